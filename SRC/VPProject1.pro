@@ -3,6 +3,12 @@
 # Project created by QtCreator 2013-02-19T01:09:17
 #
 #-------------------------------------------------
+#
+# Other targets (the processing chain is shared through lib/processing.pri):
+#   batch/VPBatch.pro          headless batch processing
+#   benchmark/VPBenchmark.pro  micro-benchmarks
+#
+#-------------------------------------------------
 
 QT       += core gui opengl
 
@@ -28,7 +34,9 @@ SOURCES += main.cpp\
         mySFM/RichFeatureMatcher.cpp \
         mySFM/SfMUpdateListener.cpp \
         mySFM/Triangulation.cpp \
-    lib/mysfminterface.cpp
+    lib/mysfminterface.cpp \
+    lib/matconverter.cpp \
+    lib/framechannel.cpp
 
 
 INCLUDEPATH += /usr/local/include/opencv/ \
@@ -46,7 +54,11 @@ HEADERS  += mainwindow.h \
     lib/robustmatcher.h \
     lib/cameracalibrator.h \
     lib/mypanelopengl.h \
-    lib/mysfminterface.h
+    lib/mysfminterface.h \
+    lib/matconverter.h \
+    lib/framechannel.h
+
+include(lib/processing.pri)
 
 FORMS    += mainwindow.ui
 
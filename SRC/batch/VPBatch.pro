@@ -0,0 +1,22 @@
+#-------------------------------------------------
+#
+# Headless batch processing with the VPProject1 processing chain
+#
+#-------------------------------------------------
+
+QT       += core
+QT       -= gui
+
+TARGET = VPBatch
+TEMPLATE = app
+CONFIG += console
+CONFIG -= app_bundle
+OBJECTS_DIR = intermediate
+
+SOURCES += main.cpp
+
+include(../lib/processing.pri)
+
+INCLUDEPATH += /usr/local/include/opencv/
+
+LIBS += `pkg-config opencv --libs`
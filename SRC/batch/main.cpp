@@ -0,0 +1,173 @@
+/*
+    @file: main.cpp (batch)
+    @license: GNU General Public License
+    @author: Juan Manuel Perez Rua
+    @note: Code written for th practical module of
+    Visual Perception at the Université de Bourgogne
+*/
+
+#include <QCoreApplication>
+#include <QStringList>
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QThread>
+#include <QTextStream>
+#include <iostream>
+#include <vector>
+#include <string>
+#include "opencv2/opencv.hpp"
+#include "pipelineconfig.h"
+#include "framesource.h"
+#include "streampipeline.h"
+#include "stageprofiler.h"
+
+static void usage(){
+    std::cout<<"Usage: VPBatch [-j threads] [-f png|jpg|...] <pipeline> <input> <outdir>"<<std::endl
+             <<"  pipeline  file with one \"key = value\" per line, or the same inline"<<std::endl
+             <<"            separated by ';' (e.g. \"gray = 1; canny = 1\")"<<std::endl
+             <<"  input     image, directory of images or video file"<<std::endl
+             <<"  outdir    processed frames and stats.txt are written here"<<std::endl;
+}
+
+static bool isImageFile(const QString &path){
+    QString ext = QFileInfo(path).suffix().toLower();
+    return ext=="jpg" || ext=="jpeg" || ext=="png" || ext=="bmp" || ext=="tif"
+        || ext=="tiff" || ext=="ppm" || ext=="pgm" || ext=="pbm";
+}
+
+static bool openInput(FrameSource &source, const QString &input){
+    QFileInfo info(input);
+    if (info.isDir()){
+        QDir dir(input);
+        QStringList names = dir.entryList(QDir::Files, QDir::Name);
+        std::vector<std::string> files;
+        for (int i=0; i<names.size(); i++)
+            if (isImageFile(names[i]))
+                files.push_back(dir.filePath(names[i]).toStdString());
+        return source.openSequence(files);
+    }
+    if (isImageFile(input)){
+        std::vector<std::string> files(1, input.toStdString());
+        return source.openSequence(files);
+    }
+    return source.openVideo(input.toStdString());
+}
+
+static QString stageLine(const char *name, const StageStats &s){
+    return QString("%1 frames=%2 latency=%3ms wait=%4ms dropped=%5")
+            .arg(name, -8).arg(s.frames).arg(s.latencyMs, 0, 'f', 2).arg(s.waitMs, 0, 'f', 2).arg(s.dropped);
+}
+
+int main(int argc, char *argv[]){
+    QCoreApplication app(argc, argv);
+    QStringList args = app.arguments();
+    int jobs = QThread::idealThreadCount();
+    QString format = "png";
+    QStringList positional;
+
+    for (int i=1; i<args.size(); i++){
+        if (args[i]=="-j" && i+1<args.size())
+            jobs = args[++i].toInt();
+        else if (args[i]=="-f" && i+1<args.size())
+            format = args[++i];
+        else if (args[i]=="-h" || args[i]=="--help"){
+            usage();
+            return 0;
+        }else
+            positional << args[i];
+    }
+    if (positional.size()!=3 || jobs<1){
+        usage();
+        return 1;
+    }
+
+    /* Pipeline description: a file, or the description itself */
+    QString description = positional[0];
+    QFile file(description);
+    if (file.exists()){
+        if (!file.open(QIODevice::ReadOnly | QIODevice::Text)){
+            std::cerr<<"Cannot open "<<description.toStdString()<<std::endl;
+            return 1;
+        }
+        description = QString::fromUtf8(file.readAll());
+    }
+    PipelineSettings settings;
+    QString error;
+    {
+        QMutexLocker locker(&settings.mutex);
+        if (!parsePipelineDescription(description, settings.config, error)){
+            std::cerr<<"Pipeline: "<<error.toStdString()<<std::endl;
+            return 1;
+        }
+        settings.changed();
+    }
+
+    FrameSource source;
+    if (!openInput(source, positional[1])){
+        std::cerr<<"Cannot open input "<<positional[1].toStdString()<<std::endl;
+        return 1;
+    }
+    QDir outdir(positional[2]);
+    if (!outdir.exists() && !QDir().mkpath(positional[2])){
+        std::cerr<<"Cannot create "<<positional[2].toStdString()<<std::endl;
+        return 1;
+    }
+
+    /* Every frame goes through, in order: blocking queues, one worker per core */
+    StageProfiler profiler;
+    StreamPipeline stream(&settings);
+    stream.setWorkers(jobs);
+    stream.setQueueCapacity(2*jobs);
+    stream.setQueuePolicy(QUEUE_BLOCK);
+    stream.setProfiler(&profiler);
+
+    int written=0, failed=0;
+    int64 start = cv::getTickCount();
+    stream.start(&source);
+    FramePacket packet;
+    while (!stream.isFinished()){
+        if (!stream.next(packet, 100))
+            continue;
+        std::string name = outdir.filePath(QString::fromStdString(source.getFrameName(packet.sequence)))
+                           .append('.').append(format).toStdString();
+        if (!packet.processed.empty() && cv::imwrite(name, packet.processed))
+            written++;
+        else{
+            std::cerr<<"Failed: "<<name<<std::endl;
+            failed++;
+        }
+        stream.presented(packet);
+    }
+    stream.stop();
+    double seconds = (double)(cv::getTickCount()-start)/cv::getTickFrequency();
+
+    /* Timing report, on stdout and in outdir/stats.txt */
+    StreamStats stats = stream.getStats();
+    QString report;
+    QTextStream out(&report);
+    out<<"pipeline:\n"<<describePipeline(settings.config)<<"\n\n";
+    out<<"input: "<<positional[1]<<"\n";
+    out<<"frames: "<<written<<" written, "<<failed<<" failed\n";
+    out<<"workers: "<<stats.workers<<"\n";
+    out<<"time: "<<QString::number(seconds, 'f', 3)<<"s ("
+       <<QString::number(seconds>0 ? (written+failed)/seconds : 0, 'f', 2)<<" frames/s)\n\n";
+    out<<stageLine("capture", stats.capture)<<"\n";
+    out<<stageLine("process", stats.process)<<"\n";
+    out<<stageLine("write", stats.present)<<"\n\n";
+    out<<QString("%1 %2 %3 %4 %5\n").arg("block", -12).arg("count", 8).arg("p50 ms", 9).arg("p95 ms", 9).arg("p99 ms", 9);
+    for (int i=0; i<PROFILE_COUNT; i++){
+        ProfileSummary s = profiler.summary((ProfileBlock)i);
+        if (s.count==0)
+            continue;
+        out<<QString("%1 %2 %3 %4 %5\n").arg(profileBlockName((ProfileBlock)i), -12).arg(s.count, 8)
+             .arg(s.p50, 9, 'f', 2).arg(s.p95, 9, 'f', 2).arg(s.p99, 9, 'f', 2);
+    }
+    out.flush();
+    std::cout<<report.toStdString();
+
+    QFile statsFile(outdir.filePath("stats.txt"));
+    if (statsFile.open(QIODevice::WriteOnly | QIODevice::Text))
+        statsFile.write(report.toUtf8());
+    return failed==0 ? 0 : 2;
+}
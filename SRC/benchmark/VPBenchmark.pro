@@ -0,0 +1,29 @@
+#-------------------------------------------------
+#
+# Benchmark suite for the VPProject1 processing code
+#
+#-------------------------------------------------
+
+QT       += core gui
+
+TARGET = VPBenchmark
+TEMPLATE = app
+CONFIG += console
+CONFIG -= app_bundle
+OBJECTS_DIR = intermediate
+
+SOURCES += main.cpp \
+        allocationcounter.cpp \
+        ../lib/matconverter.cpp \
+        ../lib/robustmatcher.cpp
+
+HEADERS  += allocationcounter.h \
+        ../lib/matconverter.h \
+        ../lib/robustmatcher.h
+
+include(../lib/processing.pri)
+
+INCLUDEPATH += /usr/local/include/opencv/ \
+                ../lib/
+
+LIBS += `pkg-config opencv --libs`
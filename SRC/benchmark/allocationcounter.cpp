@@ -0,0 +1,72 @@
+/*
+    @file: allocationcounter.cpp
+    @license: GNU General Public License
+    @author: Juan Manuel Perez Rua
+    @note: Code written for th practical module of
+    Visual Perception at the Université de Bourgogne
+*/
+
+#include "allocationcounter.h"
+#include <QAtomicInt>
+#include <cstdlib>
+#include <new>
+
+static QAtomicInt allocations;
+
+int allocationCount(){
+    return allocations;
+}
+
+#ifdef __GLIBC__
+
+/* Interpose the C allocator; glibc exports the real one as __libc_* */
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t n, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+void *__libc_memalign(size_t alignment, size_t size);
+
+void *malloc(size_t size){
+    allocations.ref();
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t n, size_t size){
+    allocations.ref();
+    return __libc_calloc(n, size);
+}
+
+void *realloc(void *ptr, size_t size){
+    allocations.ref();
+    return __libc_realloc(ptr, size);
+}
+
+void *memalign(size_t alignment, size_t size){
+    allocations.ref();
+    return __libc_memalign(alignment, size);
+}
+}
+
+#else
+
+void *operator new(std::size_t size) throw(std::bad_alloc){
+    allocations.ref();
+    void *p = std::malloc(size ? size : 1);
+    if (p==NULL)
+        throw std::bad_alloc();
+    return p;
+}
+
+void *operator new[](std::size_t size) throw(std::bad_alloc){
+    return operator new(size);
+}
+
+void operator delete(void *p) throw(){
+    std::free(p);
+}
+
+void operator delete[](void *p) throw(){
+    std::free(p);
+}
+
+#endif
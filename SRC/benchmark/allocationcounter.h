@@ -0,0 +1,17 @@
+/*
+    @file: allocationcounter.h
+    @license: GNU General Public License
+    @author: Juan Manuel Perez Rua
+    @note: Code written for th practical module of
+    Visual Perception at the Université de Bourgogne
+*/
+
+#ifndef ALLOCATIONCOUNTER_H
+#define ALLOCATIONCOUNTER_H
+
+// Number of heap allocations made by the process so far. With glibc every
+// malloc/calloc/realloc is counted (this includes cv::Mat buffers, which
+// OpenCV allocates with malloc); elsewhere only operator new is seen.
+int allocationCount();
+
+#endif // ALLOCATIONCOUNTER_H
@@ -0,0 +1,611 @@
+/*
+    @file: main.cpp (benchmark)
+    @license: GNU General Public License
+    @author: Juan Manuel Perez Rua
+    @note: Code written for th practical module of
+    Visual Perception at the Université de Bourgogne
+*/
+
+#include <QImage>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QStringList>
+#include <iostream>
+#include <algorithm>
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "opencv2/opencv.hpp"
+#include "matconverter.h"
+#include "pipelineconfig.h"
+#include "processingpipeline.h"
+#include "framesource.h"
+#include "robustmatcher.h"
+#include "histogramengine.h"
+#include "detectorregistry.h"
+#include "allocationcounter.h"
+
+/* One line of the report, also one row of the CSV output */
+struct BenchResult{
+    std::string suite;
+    std::string name;
+    std::string source;   // synthetic or recorded
+    int width;
+    int height;
+    int iterations;
+    double fps;
+    double meanMs;
+    double p50Ms;
+    double p95Ms;
+    double p99Ms;
+    double allocsPerFrame;
+};
+
+// Something to time, called with the index of the frame to work on
+class BenchBody{
+public:
+    virtual ~BenchBody(){}
+    virtual void run(int index) = 0;
+};
+
+/* Reference: the per-pixel conversion the GUI used before MatConverter */
+static QImage legacyMat2QImage(cv::Mat &mat){
+    IplImage input(mat);
+    QImage image(input.width, input.height, QImage::Format_RGB32);
+    uchar* pBits = image.bits();
+    int nBytesPerLine = image.bytesPerLine();
+    for (int n = 0; n < input.height; n++){
+        for (int m = 0; m < input.width; m++){
+            CvScalar s = cvGet2D(&input, n, m);
+            QRgb value = qRgb((uchar)s.val[2], (uchar)s.val[1], (uchar)s.val[0]);
+
+            uchar* scanLine = pBits + n * nBytesPerLine;
+            ((uint*)scanLine)[m] = value;
+        }
+    }
+    return image;
+}
+
+/* Reference: the nested scan RobustMatcher::symmetryTest used before the index */
+static void legacySymmetryTest(const std::vector< std::vector<cv::DMatch> >& matches1,
+                               const std::vector< std::vector<cv::DMatch> >& matches2,
+                               std::vector<cv::DMatch>& symMatches){
+    for (unsigned int i=0; i<matches1.size(); i++){
+        if (matches1[i].size() < 2)
+            continue;
+        for (unsigned int j=0; j<matches2.size(); j++){
+            if (matches2[j].size() < 2)
+                continue;
+            if (matches1[i][0].queryIdx==matches2[j][0].trainIdx && matches2[j][0].queryIdx==matches1[i][0].trainIdx){
+                symMatches.push_back(cv::DMatch(matches1[i][0].queryIdx, matches1[i][0].trainIdx, matches1[i][0].distance));
+                break;
+            }
+        }
+    }
+}
+
+static double percentileOf(const std::vector<double> &sorted, double p){
+    if (sorted.empty())
+        return 0;
+    unsigned int rank = (unsigned int)(p*(sorted.size()-1)+0.5);
+    return sorted[rank];
+}
+
+/* Run body once to warm up, then iterations times, cycling over count frames */
+static BenchResult measure(BenchBody &body, int count, int iterations){
+    BenchResult r;
+    std::vector<double> latencies(iterations);
+    body.run(0);
+    int allocations = allocationCount();
+    int64 total = cv::getTickCount();
+    for (int i=0; i<iterations; i++){
+        int64 start = cv::getTickCount();
+        body.run(i%count);
+        latencies[i] = 1000.0*(double)(cv::getTickCount()-start)/cv::getTickFrequency();
+    }
+    double seconds = (double)(cv::getTickCount()-total)/cv::getTickFrequency();
+    r.allocsPerFrame = (double)(allocationCount()-allocations)/iterations;
+    std::sort(latencies.begin(), latencies.end());
+    double sum=0;
+    for (int i=0; i<iterations; i++)
+        sum+=latencies[i];
+    r.iterations = iterations;
+    r.fps = seconds>0 ? iterations/seconds : 0;
+    r.meanMs = sum/iterations;
+    r.p50Ms = percentileOf(latencies, 0.50);
+    r.p95Ms = percentileOf(latencies, 0.95);
+    r.p99Ms = percentileOf(latencies, 0.99);
+    return r;
+}
+
+/** Bodies **/
+class PipelineBody : public BenchBody{
+public:
+    PipelineBody(const PipelineConfig &config, const std::vector<cv::Mat> &frames) : frames(frames){
+        this->pipeline.build(config);
+    }
+    void run(int index){ this->pipeline.run(this->frames[index]); }
+private:
+    ProcessingPipeline pipeline;
+    const std::vector<cv::Mat> &frames;
+};
+
+class LegacyConvertBody : public BenchBody{
+public:
+    LegacyConvertBody(std::vector<cv::Mat> &frames) : frames(frames){}
+    void run(int index){ this->image = legacyMat2QImage(this->frames[index]); }
+private:
+    std::vector<cv::Mat> &frames;
+    QImage image;
+};
+
+class PooledConvertBody : public BenchBody{
+public:
+    PooledConvertBody(const std::vector<cv::Mat> &frames) : frames(frames){}
+    void run(int index){ this->image = this->converter.convert(this->frames[index]); }
+private:
+    const std::vector<cv::Mat> &frames;
+    MatConverter converter;
+    QImage image;
+};
+
+// What computerVisionMachine does per frame with the histogram view on
+class HistogramBody : public BenchBody{
+public:
+    HistogramBody(const std::vector<cv::Mat> &frames) : frames(frames){}
+    void run(int index){
+        if (this->histogram.compute(this->frames[index]))
+            this->histogram.draw();
+    }
+private:
+    const std::vector<cv::Mat> &frames;
+    HistogramEngine histogram;
+};
+
+// What RobustMatcher's cache is allowed to keep between runs. COLD empties
+// it first, so every run detects, extracts and matches whatever the number
+// of frames; SAME_PAIR matches frame 0 again and only the estimation is
+// left; METHOD_SWITCH does the same alternating RANSAC and LMEDS, as when
+// the F method is changed in the GUI
+enum MatchCache{ MATCH_COLD, MATCH_SAME_PAIR, MATCH_METHOD_SWITCH };
+
+// Matches every frame against a rotated and scaled copy of itself
+class MatchBody : public BenchBody{
+public:
+    MatchBody(const std::vector<cv::Mat> &frames, DetectorKind kind=DETECTOR_SURF, double param=10,
+              MatchCache cache=MATCH_COLD) : frames(frames), cache(cache){
+        for (unsigned int i=0; i<frames.size(); i++){
+            cv::Point2f center(frames[i].cols/2.0f, frames[i].rows/2.0f);
+            cv::Mat R = cv::getRotationMatrix2D(center, 8.0, 0.9);
+            cv::Mat warped;
+            cv::warpAffine(frames[i], warped, R, frames[i].size());
+            this->views.push_back(warped);
+        }
+        // Same long-lived configuration as the GUI loop
+        this->rmatcher.setConfidenceLevel(0.98);
+        this->rmatcher.setMinDistanceToEpipolar(1.0);
+        this->rmatcher.setRatio(0.65f);
+        cv::Ptr<cv::FeatureDetector> pfd=this->detectors.detector(kind, param);
+        cv::Ptr<cv::DescriptorExtractor> pde=this->detectors.extractor(kind, param);
+        this->rmatcher.setFeatureDetector(pfd);
+        this->rmatcher.setDescriptorExtractor(pde);
+        this->rmatcher.setMatcherType(kind==DETECTOR_SURF ? MATCHER_FLANN : MATCHER_HAMMING);
+        this->method=CV_FM_RANSAC;
+        this->rmatcher.setMethod(this->method);
+    }
+    void run(int index){
+        if (this->cache==MATCH_COLD)
+            this->rmatcher.clearCache();
+        else{
+            index=0;
+            if (this->cache==MATCH_METHOD_SWITCH){
+                this->method = this->method==CV_FM_RANSAC ? CV_FM_LMEDS : CV_FM_RANSAC;
+                this->rmatcher.setMethod(this->method);
+            }
+        }
+        cv::Mat view1 = this->frames[index];
+        this->rmatcher.match(view1, this->views[index], this->matches, this->keypoints1, this->keypoints2);
+    }
+private:
+    const std::vector<cv::Mat> &frames;
+    MatchCache cache;
+    int method;
+    std::vector<cv::Mat> views;
+    DetectorRegistry detectors;
+    RobustMatcher rmatcher;
+    std::vector<cv::DMatch> matches;
+    std::vector<cv::KeyPoint> keypoints1, keypoints2;
+};
+
+// Ratio and symmetry filtering of synthetic 2-NN lists with keypoints
+// entries per image; about half the pairs are mutual. NESTED and INDEXED
+// time the symmetry test on already ratio-tested lists, FUSED both tests
+enum SymmetryMode{ SYMMETRY_NESTED, SYMMETRY_INDEXED, SYMMETRY_FUSED };
+
+class SymmetryBody : public BenchBody{
+public:
+    SymmetryBody(int keypoints, SymmetryMode mode) : mode(mode){
+        cv::RNG rng(0x5EED+keypoints);
+        this->matches1.resize(keypoints);
+        this->matches2.resize(keypoints);
+        for (int i=0; i<keypoints; i++){
+            int partner = rng.uniform(0, keypoints);
+            float best = rng.uniform(10.0f, 100.0f);
+            this->matches1[i].push_back(cv::DMatch(i, partner, best));
+            this->matches1[i].push_back(cv::DMatch(i, rng.uniform(0, keypoints), best/rng.uniform(0.4f, 1.0f)));
+            if (rng.uniform(0, 2)==0)
+                this->matches2[partner].push_back(cv::DMatch(partner, i, best));
+        }
+        for (int i=0; i<keypoints; i++){
+            if (this->matches2[i].size() > 1)
+                this->matches2[i].resize(1);
+            if (this->matches2[i].empty())
+                this->matches2[i].push_back(cv::DMatch(i, rng.uniform(0, keypoints), rng.uniform(10.0f, 100.0f)));
+            this->matches2[i].push_back(cv::DMatch(i, rng.uniform(0, keypoints), this->matches2[i][0].distance/rng.uniform(0.4f, 1.0f)));
+        }
+        this->tested1 = this->matches1;
+        this->tested2 = this->matches2;
+        this->rmatcher.ratioTest(this->tested1);
+        this->rmatcher.ratioTest(this->tested2);
+    }
+    void run(int){
+        this->symMatches.clear();
+        if (this->mode==SYMMETRY_NESTED)
+            legacySymmetryTest(this->tested1, this->tested2, this->symMatches);
+        else if (this->mode==SYMMETRY_INDEXED)
+            this->rmatcher.symmetryTest(this->tested1, this->tested2, this->symMatches);
+        else
+            this->rmatcher.symmetricRatioTest(this->matches1, this->matches2, this->symMatches);
+    }
+private:
+    SymmetryMode mode;
+    RobustMatcher rmatcher;
+    std::vector< std::vector<cv::DMatch> > matches1, matches2;
+    std::vector< std::vector<cv::DMatch> > tested1, tested2;
+    std::vector<cv::DMatch> symMatches;
+};
+
+/** Frames **/
+
+// Deterministic scene with edges, corners, blobs and circles for every detector to find
+static cv::Mat syntheticFrame(int width, int height, int seed){
+    cv::RNG rng(0x1234+seed);
+    cv::Mat frame(height, width, CV_8UC3);
+    for (int y=0; y<height; y++){
+        cv::Vec3b *row = frame.ptr<cv::Vec3b>(y);
+        for (int x=0; x<width; x++)
+            row[x] = cv::Vec3b((uchar)(x*255/width), (uchar)(y*255/height), (uchar)(128+seed*16));
+    }
+    int scale = std::min(width, height);
+    for (int i=0; i<25; i++){
+        cv::Point p1(rng.uniform(0,width), rng.uniform(0,height));
+        cv::Point p2(rng.uniform(0,width), rng.uniform(0,height));
+        cv::Scalar color(rng.uniform(0,256), rng.uniform(0,256), rng.uniform(0,256));
+        switch (i%3){
+        case 0: cv::rectangle(frame, p1, p1+cv::Point(scale/8, scale/10), color, CV_FILLED); break;
+        case 1: cv::circle(frame, p1, rng.uniform(scale/40, scale/8), color, 3); break;
+        default: cv::line(frame, p1, p2, color, 2); break;
+        }
+    }
+    cv::Mat noise(frame.size(), CV_16SC3);
+    rng.fill(noise, cv::RNG::NORMAL, cv::Scalar::all(0), cv::Scalar::all(6));
+    cv::add(frame, noise, frame, cv::noArray(), CV_8U);
+    return frame;
+}
+
+// Up to max frames from an image, a directory of images or a video
+static std::vector<cv::Mat> loadRecorded(const QString &input, unsigned int max){
+    std::vector<cv::Mat> frames;
+    FrameSource source;
+    QFileInfo info(input);
+    if (info.isDir()){
+        QDir dir(input);
+        QStringList names = dir.entryList(QStringList()<<"*.jpg"<<"*.jpeg"<<"*.png"<<"*.bmp", QDir::Files, QDir::Name);
+        std::vector<std::string> files;
+        for (int i=0; i<names.size(); i++)
+            files.push_back(dir.filePath(names[i]).toStdString());
+        source.openSequence(files);
+    }else if (!source.openVideo(input.toStdString())){
+        source.openSequence(std::vector<std::string>(1, input.toStdString()));
+    }
+    cv::Mat frame;
+    while (frames.size()<max && source.read(frame))
+        if (!frame.empty())
+            frames.push_back(frame.clone());
+    return frames;
+}
+
+/** Cases **/
+struct BenchCase{
+    BenchCase(const char *suite, const char *name, const PipelineConfig &config){
+        this->suite=suite; this->name=name; this->config=config;
+    }
+    const char *suite;
+    const char *name;
+    PipelineConfig config;
+};
+
+// One case per option computerVisionMachine offers, each alone on top of the defaults
+static std::vector<BenchCase> pipelineCases(const std::string &logoFile){
+    std::vector<BenchCase> cases;
+    PipelineConfig c;
+    cases.push_back(BenchCase("pipeline", "none", c));
+
+    c = PipelineConfig(); c.logoActivated=true; c.logoFilename=logoFile; c.xlogo=0.1; c.ylogo=0.1;
+    cases.push_back(BenchCase("logo", "logo", c));
+
+    c = PipelineConfig(); c.addSaltPepperNoise=true;
+    cases.push_back(BenchCase("noise", "saltpepper", c));
+    c = PipelineConfig(); c.addGaussianNoise=true;
+    cases.push_back(BenchCase("noise", "gaussian", c));
+
+    c = PipelineConfig(); c.convertToGray=true;
+    cases.push_back(BenchCase("color", "gray", c));
+    c = PipelineConfig(); c.equalizeHistogram=true;
+    cases.push_back(BenchCase("color", "equalize", c));
+    c = PipelineConfig(); c.rgbToHls=true;
+    cases.push_back(BenchCase("color", "hls", c));
+    c = PipelineConfig(); c.rgbToHsv=true;
+    cases.push_back(BenchCase("color", "hsv", c));
+    c = PipelineConfig(); c.rgbToYcbcr=true;
+    cases.push_back(BenchCase("color", "ycbcr", c));
+    c = PipelineConfig(); c.rgbToXyz=true;
+    cases.push_back(BenchCase("color", "xyz", c));
+    c = PipelineConfig(); c.rgbToLuv=true;
+    cases.push_back(BenchCase("color", "luv", c));
+    c = PipelineConfig(); c.rgbToLab=true;
+    cases.push_back(BenchCase("color", "lab", c));
+    c = PipelineConfig(); c.convertToGray=true; c.rgbToHsv=true; c.rgbToLab=true;
+    cases.push_back(BenchCase("color", "gray+hsv+lab", c));
+    c = PipelineConfig(); c.rgbToHsv=true; c.rgbToLab=true;
+    cases.push_back(BenchCase("color", "hsv+lab", c));
+
+    const char *morphos[] = { "OPEN", "CLOSE", "DILATE", "ERODE" };
+    for (int i=0; i<4; i++){
+        c = PipelineConfig(); c.morpho=parseMorphoType(morphos[i]); c.morphoSize=7;
+        cases.push_back(BenchCase("morpho", morphos[i], c));
+    }
+    const char *filters[] = { "BLUR", "SHARP", "SOBEL", "LAPLACIAN" };
+    for (int i=0; i<4; i++){
+        c = PipelineConfig(); c.filter=parseFilterType(filters[i]);
+        cases.push_back(BenchCase("filter", filters[i], c));
+    }
+
+    c = PipelineConfig(); c.canny=true;
+    cases.push_back(BenchCase("edges", "canny", c));
+    c = PipelineConfig(); c.hough=HOUGH_LINES;
+    cases.push_back(BenchCase("hough", "LINES", c));
+    c = PipelineConfig(); c.hough=HOUGH_LINES; c.houghTracking=true;
+    cases.push_back(BenchCase("hough", "LINES_TRACKED", c));
+    c = PipelineConfig(); c.canny=true; c.hough=HOUGH_LINES;
+    cases.push_back(BenchCase("hough", "CANNY_LINES", c));
+    c = PipelineConfig(); c.hough=HOUGH_CIRCLES;
+    cases.push_back(BenchCase("hough", "CIRCLES", c));
+    c = PipelineConfig(); c.hough=HOUGH_CIRCLES; c.houghMinRadius=10; c.houghMaxRadius=120; c.houghPyramid=1;
+    cases.push_back(BenchCase("hough", "CIRCLES_RANGE", c));
+
+    c = PipelineConfig(); c.conObjs=true;
+    cases.push_back(BenchCase("shape", "conobjs", c));
+    c = PipelineConfig(); c.contours=true;
+    cases.push_back(BenchCase("shape", "contours", c));
+    const char *shapes[] = { "BOX", "CIRCLE", "CENTER" };
+    for (int i=0; i<3; i++){
+        c = PipelineConfig(); c.shape=parseShapeType(shapes[i]);
+        cases.push_back(BenchCase("shape", shapes[i], c));
+    }
+
+    const char *features[] = { "MSER", "HARRIS", "HARRIS_NMS", "STAR", "FAST", "SIFT", "SURF" };
+    for (int i=0; i<7; i++){
+        c = PipelineConfig(); c.feature=parseFeatureType(features[i]);
+        cases.push_back(BenchCase("feature", features[i], c));
+    }
+    return cases;
+}
+
+/** Reporting **/
+static void printResult(const BenchResult &r){
+    printf("%-8s %-11s %-9s %4dx%-4d %8.1f fps  mean %8.3f  p50 %8.3f  p95 %8.3f  p99 %8.3f ms  %8.1f allocs/frame\n",
+           r.suite.c_str(), r.name.c_str(), r.source.c_str(), r.width, r.height,
+           r.fps, r.meanMs, r.p50Ms, r.p95Ms, r.p99Ms, r.allocsPerFrame);
+    fflush(stdout);
+}
+
+static bool writeCsv(const char *path, const std::vector<BenchResult> &results){
+    FILE *f = fopen(path, "w");
+    if (f==NULL)
+        return false;
+    fprintf(f, "suite,name,source,width,height,iterations,fps,mean_ms,p50_ms,p95_ms,p99_ms,allocs_per_frame\n");
+    for (unsigned int i=0; i<results.size(); i++){
+        const BenchResult &r = results[i];
+        fprintf(f, "%s,%s,%s,%d,%d,%d,%.3f,%.4f,%.4f,%.4f,%.4f,%.2f\n",
+                r.suite.c_str(), r.name.c_str(), r.source.c_str(), r.width, r.height, r.iterations,
+                r.fps, r.meanMs, r.p50Ms, r.p95Ms, r.p99Ms, r.allocsPerFrame);
+    }
+    fclose(f);
+    return true;
+}
+
+static void usage(){
+    std::cout<<"Usage: VPBenchmark [-n iterations] [-s WxH]... [-i recorded] [-m match] [-o results.csv]"<<std::endl
+             <<"  -n  timed iterations per case (default 30, matching uses a quarter)"<<std::endl
+             <<"  -s  resolution, repeatable (default 320x240 640x480 1280x720 1920x1080)"<<std::endl
+             <<"  -i  image, directory or video to benchmark on besides the synthetic frames"<<std::endl
+             <<"  -m  only run cases whose \"suite/name\" contains this text"<<std::endl
+             <<"  -o  write the results as CSV, for diffing between builds"<<std::endl;
+}
+
+static bool selected(const std::string &filter, const std::string &suite, const std::string &name){
+    return filter.empty() || (suite+"/"+name).find(filter)!=std::string::npos;
+}
+
+static void benchFrameSet(std::vector<cv::Mat> &frames, const char *source, int iterations,
+                          const std::vector<BenchCase> &cases, const std::string &filter,
+                          std::vector<BenchResult> &results){
+    int width = frames[0].cols, height = frames[0].rows;
+    int count = frames.size();
+    for (unsigned int c=0; c<cases.size(); c++){
+        if (!selected(filter, cases[c].suite, cases[c].name))
+            continue;
+        PipelineBody body(cases[c].config, frames);
+        BenchResult r = measure(body, count, iterations);
+        r.suite=cases[c].suite; r.name=cases[c].name; r.source=source; r.width=width; r.height=height;
+        printResult(r);
+        results.push_back(r);
+    }
+    if (selected(filter, "convert", "legacy")){
+        LegacyConvertBody body(frames);
+        BenchResult r = measure(body, count, std::max(1, iterations/4));
+        r.suite="convert"; r.name="legacy"; r.source=source; r.width=width; r.height=height;
+        printResult(r);
+        results.push_back(r);
+    }
+    if (selected(filter, "convert", "pooled")){
+        PooledConvertBody body(frames);
+        BenchResult r = measure(body, count, iterations);
+        r.suite="convert"; r.name="pooled"; r.source=source; r.width=width; r.height=height;
+        printResult(r);
+        results.push_back(r);
+    }
+    if (selected(filter, "histogram", "engine")){
+        HistogramBody body(frames);
+        BenchResult r = measure(body, count, iterations);
+        r.suite="histogram"; r.name="engine"; r.source=source; r.width=width; r.height=height;
+        printResult(r);
+        results.push_back(r);
+    }
+    if (selected(filter, "match", "robustmatcher")){
+        MatchBody body(frames);
+        BenchResult r = measure(body, count, std::max(1, iterations/4));
+        r.suite="match"; r.name="robustmatcher"; r.source=source; r.width=width; r.height=height;
+        printResult(r);
+        results.push_back(r);
+    }
+    // The cache speed-up, on one pair primed by the warm-up run
+    if (selected(filter, "match", "cached-pair")){
+        MatchBody body(frames, DETECTOR_SURF, 10, MATCH_SAME_PAIR);
+        BenchResult r = measure(body, 1, iterations);
+        r.suite="match"; r.name="cached-pair"; r.source=source; r.width=width; r.height=height;
+        printResult(r);
+        results.push_back(r);
+    }
+    if (selected(filter, "match", "cached-method")){
+        MatchBody body(frames, DETECTOR_SURF, 10, MATCH_METHOD_SWITCH);
+        BenchResult r = measure(body, 1, iterations);
+        r.suite="match"; r.name="cached-method"; r.source=source; r.width=width; r.height=height;
+        printResult(r);
+        results.push_back(r);
+    }
+    // Binary descriptors with the same settings as the GUI's ORB and BRISK options
+    if (selected(filter, "match", "orb")){
+        MatchBody body(frames, DETECTOR_ORB, 2000);
+        BenchResult r = measure(body, count, iterations);
+        r.suite="match"; r.name="orb"; r.source=source; r.width=width; r.height=height;
+        printResult(r);
+        results.push_back(r);
+    }
+    if (selected(filter, "match", "brisk")){
+        MatchBody body(frames, DETECTOR_BRISK, 30);
+        BenchResult r = measure(body, count, iterations);
+        r.suite="match"; r.name="brisk"; r.source=source; r.width=width; r.height=height;
+        printResult(r);
+        results.push_back(r);
+    }
+}
+
+// Symmetry test scaling; reported with the keypoint count as width.
+// The nested scan is quadratic, so it stops at 10k keypoints
+static void benchSymmetry(int iterations, const std::string &filter, std::vector<BenchResult> &results){
+    const char *names[] = { "sym-nested", "sym-indexed", "sym-fused" };
+    const int counts[] = { 1000, 10000, 100000 };
+    for (int m=0; m<3; m++){
+        if (!selected(filter, "match", names[m]))
+            continue;
+        for (int k=0; k<3; k++){
+            if (m==SYMMETRY_NESTED && counts[k]>10000)
+                continue;
+            SymmetryBody body(counts[k], (SymmetryMode)m);
+            BenchResult r = measure(body, 1, m==SYMMETRY_NESTED ? std::max(1, iterations/10) : iterations);
+            r.suite="match"; r.name=names[m]; r.source="synthetic"; r.width=counts[k]; r.height=1;
+            printResult(r);
+            results.push_back(r);
+        }
+    }
+}
+
+int main(int argc, char *argv[]){
+    int iterations = 30;
+    std::vector<cv::Size> sizes;
+    const char *csv = NULL;
+    const char *input = NULL;
+    std::string filter;
+
+    for (int i=1; i<argc; i++){
+        if (strcmp(argv[i],"-n")==0 && i+1<argc)
+            iterations = atoi(argv[++i]);
+        else if (strcmp(argv[i],"-s")==0 && i+1<argc){
+            int w, h;
+            if (sscanf(argv[++i], "%dx%d", &w, &h)==2 && w>0 && h>0)
+                sizes.push_back(cv::Size(w,h));
+        }else if (strcmp(argv[i],"-i")==0 && i+1<argc)
+            input = argv[++i];
+        else if (strcmp(argv[i],"-m")==0 && i+1<argc)
+            filter = argv[++i];
+        else if (strcmp(argv[i],"-o")==0 && i+1<argc)
+            csv = argv[++i];
+        else{
+            usage();
+            return strcmp(argv[i],"-h")==0 ? 0 : 1;
+        }
+    }
+    if (iterations<1)
+        iterations = 1;
+    if (sizes.empty()){
+        sizes.push_back(cv::Size(320,240));
+        sizes.push_back(cv::Size(640,480));
+        sizes.push_back(cv::Size(1280,720));
+        sizes.push_back(cv::Size(1920,1080));
+    }
+
+    /* The logo stage needs a file: write a small synthetic one */
+    std::string logoFile = QDir::temp().filePath("vpbenchmark_logo.png").toStdString();
+    cv::imwrite(logoFile, syntheticFrame(64, 48, 99));
+    std::vector<BenchCase> cases = pipelineCases(logoFile);
+
+    std::vector<cv::Mat> recorded;
+    if (input!=NULL){
+        recorded = loadRecorded(input, 8);
+        if (recorded.empty()){
+            std::cerr<<"Cannot read frames from "<<input<<std::endl;
+            return 1;
+        }
+    }
+
+    std::vector<BenchResult> results;
+    for (unsigned int s=0; s<sizes.size(); s++){
+        std::vector<cv::Mat> frames;
+        for (int i=0; i<4; i++)
+            frames.push_back(syntheticFrame(sizes[s].width, sizes[s].height, i));
+        benchFrameSet(frames, "synthetic", iterations, cases, filter, results);
+
+        if (!recorded.empty()){
+            frames.clear();
+            for (unsigned int i=0; i<recorded.size(); i++){
+                cv::Mat resized;
+                cv::resize(recorded[i], resized, sizes[s], 0, 0, cv::INTER_AREA);
+                frames.push_back(resized);
+            }
+            benchFrameSet(frames, "recorded", iterations, cases, filter, results);
+        }
+    }
+    benchSymmetry(iterations, filter, results);
+
+    QFile::remove(QString::fromStdString(logoFile));
+    if (csv!=NULL && !writeCsv(csv, results)){
+        std::cerr<<"Cannot write "<<csv<<std::endl;
+        return 1;
+    }
+    return 0;
+}
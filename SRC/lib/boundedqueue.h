@@ -0,0 +1,218 @@
+/*
+    @file: boundedqueue.h
+    @license: GNU General Public License
+    @author: Juan Manuel Perez Rua
+    @note: Code written for th practical module of
+    Visual Perception at the Université de Bourgogne
+*/
+
+#ifndef BOUNDEDQUEUE_H
+#define BOUNDEDQUEUE_H
+
+#include <vector>
+#include <QAtomicInt>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QTime>
+
+// What push() does when the queue is full
+enum QueuePolicy{
+    QUEUE_DROP_OLDEST, // discard the oldest element and keep going (live video)
+    QUEUE_BLOCK        // wait until a consumer makes room (never lose frames)
+};
+
+// Fixed capacity multi-producer/multi-consumer ring buffer. push and pop
+// are lock-free (one compare-and-swap on the ring position, D. Vyukov's
+// bounded queue); the mutex and wait conditions are only used to park a
+// thread when the ring is empty (pop) or full (push with QUEUE_BLOCK).
+template <typename T>
+class BoundedQueue{
+public:
+    BoundedQueue(int capacity=4, QueuePolicy policy=QUEUE_DROP_OLDEST);
+    bool push(const T &item);
+    bool tryPop(T &item);
+    bool pop(T &item, int timeoutMs);
+    void close();
+    void reopen();
+    bool isClosed();
+    void setPolicy(QueuePolicy policy);
+    int size();
+    int capacity() const;
+    int getDropped();
+
+private:
+    struct Cell{
+        QAtomicInt sequence;
+        T data;
+    };
+    bool tryPush(const T &item);
+    void wake();
+    std::vector<Cell> cells;
+    int mask;
+    QAtomicInt enqueuePos;
+    QAtomicInt dequeuePos;
+    QAtomicInt closed;
+    QAtomicInt dropped;
+    QAtomicInt sleepers;
+    QueuePolicy policy;
+    QMutex waitMutex;
+    QWaitCondition changedCondition;
+    BoundedQueue(const BoundedQueue &);
+    BoundedQueue &operator=(const BoundedQueue &);
+};
+
+template <typename T>
+BoundedQueue<T>::BoundedQueue(int capacity, QueuePolicy policy){
+    int n=2;
+    while (n<capacity)
+        n<<=1;
+    this->cells.resize(n);
+    for (int i=0; i<n; i++)
+        this->cells[i].sequence = i;
+    this->mask = n-1;
+    this->policy = policy;
+}
+
+template <typename T>
+bool BoundedQueue<T>::tryPush(const T &item){
+    Cell *cell;
+    int pos = this->enqueuePos;
+    for (;;){
+        cell = &this->cells[pos & this->mask];
+        int seq = cell->sequence.fetchAndAddAcquire(0);
+        int dif = seq - pos;
+        if (dif==0){
+            if (this->enqueuePos.testAndSetRelaxed(pos, pos+1))
+                break;
+            pos = this->enqueuePos;
+        }else if (dif<0){
+            return false; // full
+        }else{
+            pos = this->enqueuePos;
+        }
+    }
+    cell->data = item;
+    cell->sequence.fetchAndStoreRelease(pos+1);
+    return true;
+}
+
+template <typename T>
+bool BoundedQueue<T>::tryPop(T &item){
+    Cell *cell;
+    int pos = this->dequeuePos;
+    for (;;){
+        cell = &this->cells[pos & this->mask];
+        int seq = cell->sequence.fetchAndAddAcquire(0);
+        int dif = seq - (pos+1);
+        if (dif==0){
+            if (this->dequeuePos.testAndSetRelaxed(pos, pos+1))
+                break;
+            pos = this->dequeuePos;
+        }else if (dif<0){
+            return false; // empty
+        }else{
+            pos = this->dequeuePos;
+        }
+    }
+    item = cell->data;
+    cell->data = T(); // do not keep frame buffers alive inside the ring
+    cell->sequence.fetchAndStoreRelease(pos+this->mask+1);
+    wake();
+    return true;
+}
+
+template <typename T>
+void BoundedQueue<T>::wake(){
+    if (this->sleepers>0){
+        QMutexLocker locker(&this->waitMutex);
+        this->changedCondition.wakeAll();
+    }
+}
+
+// Returns false only when the queue has been closed
+template <typename T>
+bool BoundedQueue<T>::push(const T &item){
+    for (;;){
+        if (this->closed)
+            return false;
+        if (tryPush(item)){
+            wake();
+            return true;
+        }
+        if (this->policy==QUEUE_DROP_OLDEST){
+            T oldest;
+            if (tryPop(oldest))
+                this->dropped.ref();
+        }else{
+            QMutexLocker locker(&this->waitMutex);
+            this->sleepers.ref();
+            // The timeout only covers a wake-up lost between the two checks
+            if (size()>=capacity() && !this->closed)
+                this->changedCondition.wait(&this->waitMutex, 10);
+            this->sleepers.deref();
+        }
+    }
+}
+
+// Wait up to timeoutMs for an element; false on timeout or when closed and empty
+template <typename T>
+bool BoundedQueue<T>::pop(T &item, int timeoutMs){
+    QTime timer;
+    timer.start();
+    for (;;){
+        if (tryPop(item))
+            return true;
+        int left = timeoutMs-timer.elapsed();
+        if (this->closed || left<=0)
+            return false;
+        QMutexLocker locker(&this->waitMutex);
+        this->sleepers.ref();
+        if (size()==0 && !this->closed)
+            this->changedCondition.wait(&this->waitMutex, left<10 ? left : 10);
+        this->sleepers.deref();
+    }
+}
+
+template <typename T>
+void BoundedQueue<T>::close(){
+    QMutexLocker locker(&this->waitMutex);
+    this->closed.fetchAndStoreOrdered(1);
+    this->changedCondition.wakeAll();
+}
+
+template <typename T>
+void BoundedQueue<T>::reopen(){
+    T item;
+    while (tryPop(item)){}
+    this->closed.fetchAndStoreOrdered(0);
+}
+
+template <typename T>
+bool BoundedQueue<T>::isClosed(){
+    return this->closed!=0;
+}
+
+template <typename T>
+void BoundedQueue<T>::setPolicy(QueuePolicy policy){
+    this->policy = policy;
+}
+
+// Approximate number of queued elements (exact when nobody is pushing/popping)
+template <typename T>
+int BoundedQueue<T>::size(){
+    int n = int(this->enqueuePos) - int(this->dequeuePos);
+    if (n<0) return 0;
+    return n>capacity() ? capacity() : n;
+}
+
+template <typename T>
+int BoundedQueue<T>::capacity() const{
+    return this->mask+1;
+}
+
+template <typename T>
+int BoundedQueue<T>::getDropped(){
+    return this->dropped;
+}
+
+#endif // BOUNDEDQUEUE_H
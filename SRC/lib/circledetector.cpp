@@ -0,0 +1,252 @@
+/*
+    @file: circledetector.cpp
+    @license: GNU General Public License
+    @author: Juan Manuel Perez Rua
+    @note: Code written for th practical module of
+    Visual Perception at the Université de Bourgogne
+*/
+
+#include "circledetector.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+enum{ VOTE_SHIFT=10, VOTE_ONE=1<<VOTE_SHIFT };
+
+class CircleVoteBody : public cv::ParallelLoopBody{
+public:
+    CircleVoteBody(CircleDetector *detector, int bands) : detector(detector), bands(bands){}
+    void operator()(const cv::Range &range) const{
+        for (int b=range.start; b<range.end; b++)
+            this->detector->vote(b, this->bands);
+    }
+private:
+    CircleDetector *detector;
+    int bands;
+};
+
+struct PointXLess{
+    bool operator()(const cv::Point &a, const cv::Point &b) const{ return a.x<b.x; }
+};
+
+struct CenterCandidate{
+    int votes, index;
+    bool operator<(const CenterCandidate &other) const{
+        return this->votes!=other.votes ? this->votes>other.votes : this->index<other.index;
+    }
+};
+
+CircleDetector::CircleDetector(){
+    this->centerVotes=100;
+    this->minDistance=1;
+    this->minRadius=0;
+    this->maxRadius=0;
+    this->tracking=false;
+    this->framesSinceDetection=REDETECT_FRAMES;
+    this->detectedEdgePixels=0;
+    this->lastFrame=0;
+    this->dx=NULL;
+    this->dy=NULL;
+    this->maxR=0;
+}
+
+// Votes a centre needs, and edge pixels a circle needs (HoughCircles param2)
+void CircleDetector::setVotes(int centerVotes){
+    this->centerVotes = centerVotes<1 ? 1 : centerVotes;
+}
+
+void CircleDetector::setMinDistance(double distance){
+    this->minDistance=distance;
+}
+
+// maxRadius 0: up to the largest frame side, as HoughCircles does
+void CircleDetector::setRadiusRange(int minRadius, int maxRadius){
+    this->minRadius = std::max(0, minRadius);
+    this->maxRadius = std::max(0, maxRadius);
+    this->framesSinceDetection=REDETECT_FRAMES;
+}
+
+void CircleDetector::setTracking(bool tracking){
+    this->tracking=tracking;
+    this->framesSinceDetection=REDETECT_FRAMES;
+}
+
+// Floor and ceiling of a/b for b>0
+static inline int floorDiv(int a, int b){
+    return a>=0 ? a/b : -((-a+b-1)/b);
+}
+
+static inline int ceilDiv(int a, int b){
+    return -floorDiv(-a, b);
+}
+
+/* Votes falling on the band-th band of accumulator rows. Only edge pixels
+   within maxR rows can reach it, and of their rays only the radii whose
+   centre row is inside the band are walked */
+void CircleDetector::vote(int band, int bands){
+    int w = this->size.width, h = this->size.height;
+    int top = band*h/bands, bottom = (band+1)*h/bands;
+    std::fill(this->accumulator.begin()+top*w, this->accumulator.begin()+bottom*w, 0);
+    int first = this->rowStart[std::max(0, top-this->maxR)];
+    int last = this->rowStart[std::min(h, bottom+this->maxR)];
+    int low = top*VOTE_ONE, high = bottom*VOTE_ONE;
+    for (int i=first; i<last; i++){
+        cv::Point p = this->points[i];
+        float vx = this->dx->at<short>(p), vy = this->dy->at<short>(p);
+        float mag = std::sqrt(vx*vx+vy*vy);
+        int sx = cvRound(vx*VOTE_ONE/mag), sy = cvRound(vy*VOTE_ONE/mag);
+        int px = p.x*VOTE_ONE, py = p.y*VOTE_ONE;
+        for (int k=0; k<2; k++){
+            // Radii with low <= py + r*sy < high
+            int from = this->minRadius, to = this->maxR;
+            if (sy>0){
+                from = std::max(from, ceilDiv(low-py, sy));
+                to = std::min(to, ceilDiv(high-py, sy)-1);
+            }else if (sy<0){
+                from = std::max(from, floorDiv(py-high, -sy)+1);
+                to = std::min(to, floorDiv(py-low, -sy));
+            }else if (py<low || py>=high)
+                to = from-1;
+            int x1 = px + from*sx, y1 = py + from*sy;
+            for (int r=from; r<=to; r++, x1+=sx, y1+=sy){
+                // x leaves the frame only once along the ray
+                int x = x1>>VOTE_SHIFT;
+                if ((unsigned)x>=(unsigned)w)
+                    break;
+                this->accumulator[(y1>>VOTE_SHIFT)*w+x]++;
+            }
+            sx=-sx;
+            sy=-sy;
+        }
+    }
+}
+
+/* Radius with the most edge pixels around center, relative to its length
+   (a big circle has more pixels); returns that number of pixels. Only the
+   edge pixels of the maxR box around the centre are looked at */
+int CircleDetector::bestRadius(const cv::Point2f &center, float &radius){
+    this->radii.assign(this->maxR+2, 0);
+    float min2 = float(this->minRadius)*this->minRadius, max2 = float(this->maxR)*this->maxR;
+    int top = std::max(0, (int)std::floor(center.y-this->maxR));
+    int bottom = std::min(this->size.height-1, (int)std::ceil(center.y+this->maxR));
+    int left = (int)std::floor(center.x-this->maxR), right = (int)std::ceil(center.x+this->maxR);
+    for (int y=top; y<=bottom; y++){
+        std::vector<cv::Point>::const_iterator begin = this->points.begin()+this->rowStart[y];
+        std::vector<cv::Point>::const_iterator end = this->points.begin()+this->rowStart[y+1];
+        // Points of a row are sorted by x
+        std::vector<cv::Point>::const_iterator it = std::lower_bound(begin, end, cv::Point(left, y), PointXLess());
+        float ddy = y-center.y;
+        for (; it!=end && it->x<=right; ++it){
+            float ddx = it->x-center.x;
+            float d2 = ddx*ddx+ddy*ddy;
+            if (d2>=min2 && d2<=max2)
+                this->radii[cvRound(std::sqrt(d2))]++;
+        }
+    }
+    int best=0;
+    radius=0;
+    for (int r=std::max(1, this->minRadius); r<=this->maxR; r++){
+        if (radius==0 ? this->radii[r]>best : this->radii[r]*radius>best*r){
+            best=this->radii[r];
+            radius=r;
+        }
+    }
+    return best;
+}
+
+/* Keep the previous circles while the edges still cover most of each one */
+bool CircleDetector::track(const cv::Mat &edges){
+    if (this->circles.empty() || this->framesSinceDetection>=REDETECT_FRAMES)
+        return false;
+    int edgePixels = cv::countNonZero(edges);
+    if (abs(edgePixels-this->detectedEdgePixels) > this->detectedEdgePixels/10)
+        return false;
+    for (unsigned int i=0; i<this->circles.size(); i++){
+        float cx = this->circles[i][0], cy = this->circles[i][1], r = this->circles[i][2];
+        int samples = std::max(8, cvRound(2*CV_PI*r)), supported=0;
+        for (int s=0; s<samples; s++){
+            double a = 2*CV_PI*s/samples;
+            int x = cvRound(cx + r*cos(a)), y = cvRound(cy + r*sin(a));
+            bool edge=false;
+            for (int dy=-1; dy<=1 && !edge; dy++)
+                for (int dx=-1; dx<=1 && !edge; dx++)
+                    edge = x+dx>=0 && y+dy>=0 && x+dx<edges.cols && y+dy<edges.rows
+                            && edges.at<uchar>(y+dy, x+dx)!=0;
+            if (edge)
+                supported++;
+        }
+        if (supported*2 < samples)
+            return false;
+    }
+    return true;
+}
+
+// Circles as (x, y, radius). edges is CV_8U, dx and dy its CV_16S Sobel
+// gradients, frame the capture sequence number
+const std::vector<cv::Vec3f> &CircleDetector::detect(const cv::Mat &edges, const cv::Mat &dx, const cv::Mat &dy,
+                                                     uint64 frame){
+    CV_Assert(edges.type()==CV_8U && dx.type()==CV_16S && dy.type()==CV_16S);
+    bool consecutive = frame==this->lastFrame+1;
+    this->lastFrame=frame;
+    if (this->tracking && consecutive && track(edges)){
+        this->framesSinceDetection++;
+        return this->circles;
+    }
+    this->circles.clear();
+    this->dx=&dx;
+    this->dy=&dy;
+    this->size=edges.size();
+    this->maxR = this->maxRadius>0 ? this->maxRadius : std::max(edges.rows, edges.cols);
+
+    this->points.clear();
+    this->rowStart.resize(edges.rows+1);
+    for (int y=0; y<edges.rows; y++){
+        this->rowStart[y] = this->points.size();
+        const uchar *e = edges.ptr<uchar>(y);
+        const short *gx = dx.ptr<short>(y), *gy = dy.ptr<short>(y);
+        for (int x=0; x<edges.cols; x++)
+            if (e[x] && (gx[x] || gy[x]))
+                this->points.push_back(cv::Point(x, y));
+    }
+    this->rowStart[edges.rows] = this->points.size();
+    this->framesSinceDetection=0;
+    this->detectedEdgePixels=cv::countNonZero(edges);
+    if (this->points.empty())
+        return this->circles;
+
+    /* Centre votes, a band of accumulator rows per task */
+    this->accumulator.resize(this->size.area());
+    int bands = std::max(1, std::min(4*cv::getNumThreads(), edges.rows/16));
+    cv::parallel_for_(cv::Range(0, bands), CircleVoteBody(this, bands));
+
+    /* Local maxima over the vote threshold, strongest first */
+    std::vector<CenterCandidate> candidates;
+    int w = this->size.width;
+    for (int y=1; y<this->size.height-1; y++){
+        const int *row = &this->accumulator[y*w];
+        for (int x=1; x<w-1; x++){
+            int v = row[x];
+            if (v>this->centerVotes && v>row[x-1] && v>=row[x+1] && v>row[x-w] && v>=row[x+w]){
+                CenterCandidate candidate = { v, y*w+x };
+                candidates.push_back(candidate);
+            }
+        }
+    }
+    std::sort(candidates.begin(), candidates.end());
+
+    double minDistance2 = this->minDistance*this->minDistance;
+    for (unsigned int i=0; i<candidates.size(); i++){
+        cv::Point2f center(candidates[i].index%w + 0.5f, candidates[i].index/w + 0.5f);
+        bool close=false;
+        for (unsigned int j=0; j<this->circles.size() && !close; j++){
+            float ddx = this->circles[j][0]-center.x, ddy = this->circles[j][1]-center.y;
+            close = ddx*ddx+ddy*ddy < minDistance2;
+        }
+        if (close)
+            continue;
+        float radius;
+        if (bestRadius(center, radius)>this->centerVotes)
+            this->circles.push_back(cv::Vec3f(center.x, center.y, radius));
+    }
+    return this->circles;
+}
@@ -0,0 +1,60 @@
+/*
+    @file: circledetector.h
+    @license: GNU General Public License
+    @author: Juan Manuel Perez Rua
+    @note: Code written for th practical module of
+    Visual Perception at the Université de Bourgogne
+*/
+
+#ifndef CIRCLEDETECTOR_H
+#define CIRCLEDETECTOR_H
+
+#include <vector>
+#include "opencv2/opencv.hpp"
+
+// Hough gradient circle detection (the HOUGH CIRCLES replacement for
+// cv::HoughCircles) working from an edge plane and Sobel gradients the
+// caller already has, so the frame gradients are not recomputed here.
+// Every edge pixel votes for centres along its gradient, both ways, only
+// for radii in [minRadius, maxRadius]. The accumulator is shared and split
+// into bands of rows, one thread per band: it clears its rows and walks
+// only the part of each ray that crosses them, so no partial accumulators
+// need merging. Centres
+// are taken strongest first, at least minDistance apart, and kept when
+// enough edge pixels lie at one distance from them. With tracking on, the
+// previous circles are checked first and kept while the edges still
+// support them (full detection again every REDETECT_FRAMES frames); like
+// LineDetector, only the circles of frame-1 are ever kept.
+class CircleDetector{
+public:
+    enum{ REDETECT_FRAMES=10 };
+    CircleDetector();
+    void setVotes(int centerVotes);
+    void setMinDistance(double distance);
+    void setRadiusRange(int minRadius, int maxRadius);
+    void setTracking(bool tracking);
+    const std::vector<cv::Vec3f> &detect(const cv::Mat &edges, const cv::Mat &dx, const cv::Mat &dy,
+                                         uint64 frame);
+private:
+    friend class CircleVoteBody;
+    void vote(int band, int bands);
+    bool track(const cv::Mat &edges);
+    int bestRadius(const cv::Point2f &center, float &radius);
+    int centerVotes;
+    double minDistance;
+    int minRadius, maxRadius;
+    bool tracking;
+    int framesSinceDetection;
+    int detectedEdgePixels;
+    uint64 lastFrame;                   // frame number of the previous detect()
+    const cv::Mat *dx, *dy;
+    int maxR;                           // maxRadius resolved for the frame
+    cv::Size size;
+    std::vector<cv::Point> points;      // edge pixels with a gradient, raster order
+    std::vector<int> rowStart;          // first of points on each row, height+1 entries
+    std::vector<int> accumulator;
+    std::vector<int> radii;             // edge pixels per distance to a centre
+    std::vector<cv::Vec3f> circles;
+};
+
+#endif // CIRCLEDETECTOR_H
@@ -0,0 +1,119 @@
+/*
+    @file: colorchain.cpp
+    @license: GNU General Public License
+    @author: Juan Manuel Perez Rua
+    @note: Code written for th practical module of
+    Visual Perception at the Université de Bourgogne
+*/
+
+#include "colorchain.h"
+#include <algorithm>
+
+/* Same fixed point luminance as cvtColor(CV_BGR2GRAY) */
+enum{ GRAY_SHIFT=14, GRAY_B=1868, GRAY_G=9617, GRAY_R=4899 };
+
+class GrayTableBody : public cv::ParallelLoopBody{
+public:
+    GrayTableBody(const cv::Mat *gray, cv::Mat &image, const uchar *table)
+        : gray(gray), image(image), table(table){}
+    void operator()(const cv::Range &stripes) const{
+        for (int s=stripes.start; s<stripes.end; s++){
+            int end = std::min(this->image.rows, (s+1)*ColorChain::STRIPE_ROWS);
+            for (int r=s*ColorChain::STRIPE_ROWS; r<end; r++){
+                uchar *p = this->image.ptr<uchar>(r);
+                if (this->gray){
+                    const uchar *g = this->gray->ptr<uchar>(r);
+                    for (int x=0; x<this->image.cols; x++, p+=3){
+                        const uchar *t = this->table + 3*g[x];
+                        p[0]=t[0]; p[1]=t[1]; p[2]=t[2];
+                    }
+                }else{
+                    for (int x=0; x<this->image.cols; x++, p+=3){
+                        int g = (p[0]*GRAY_B + p[1]*GRAY_G + p[2]*GRAY_R + (1<<(GRAY_SHIFT-1))) >> GRAY_SHIFT;
+                        const uchar *t = this->table + 3*g;
+                        p[0]=t[0]; p[1]=t[1]; p[2]=t[2];
+                    }
+                }
+            }
+        }
+    }
+private:
+    const cv::Mat *gray;    // NULL: compute the luminance from image
+    cv::Mat &image;
+    const uchar *table;
+};
+
+class ConversionBody : public cv::ParallelLoopBody{
+public:
+    ConversionBody(cv::Mat &image, const std::vector<int> &codes)
+        : image(image), codes(codes){}
+    void operator()(const cv::Range &stripes) const{
+        int start = stripes.start*ColorChain::STRIPE_ROWS;
+        int end = std::min(this->image.rows, stripes.end*ColorChain::STRIPE_ROWS);
+        for (int r=start; r<end; r+=ColorChain::STRIPE_ROWS){
+            cv::Mat rows = this->image.rowRange(r, std::min(end, r+ColorChain::STRIPE_ROWS));
+            for (unsigned int i=0; i<this->codes.size(); i++)
+                cv::cvtColor(rows, rows, this->codes[i]);
+        }
+    }
+private:
+    cv::Mat &image;
+    const std::vector<int> &codes;
+};
+
+ColorChain::ColorChain(){
+    this->gray=false;
+}
+
+// codes are BGR->X cvtColor codes, applied in order after the optional gray conversion
+void ColorChain::build(bool gray, const std::vector<int> &codes){
+    this->gray=gray;
+    this->codes=codes;
+    this->table.release();
+    if (!gray)
+        return;
+    this->table.create(1, 256, CV_8UC3);
+    for (int g=0; g<256; g++)
+        this->table.at<cv::Vec3b>(0, g) = cv::Vec3b(g, g, g);
+    for (unsigned int i=0; i<codes.size(); i++)
+        cv::cvtColor(this->table, this->table, codes[i]);
+}
+
+bool ColorChain::isGrayChain() const{
+    return this->gray;
+}
+
+// Number of conversions the chain replaces
+int ColorChain::size() const{
+    return this->codes.size() + (this->gray ? 1 : 0);
+}
+
+void ColorChain::apply(cv::Mat &image) const{
+    if (image.empty() || size()==0)
+        return;
+    if (image.type()!=CV_8UC3){
+        // Nothing to gain on unusual frames, keep the plain chain
+        if (this->gray){
+            cv::Mat grayPlane = image;
+            if (image.channels()!=1)
+                cv::cvtColor(image, grayPlane, CV_BGR2GRAY);
+            cv::cvtColor(grayPlane, image, CV_GRAY2BGR);
+        }
+        for (unsigned int i=0; i<this->codes.size(); i++)
+            cv::cvtColor(image, image, this->codes[i]);
+        return;
+    }
+    int stripes = (image.rows+STRIPE_ROWS-1)/STRIPE_ROWS;
+    if (this->gray)
+        cv::parallel_for_(cv::Range(0, stripes), GrayTableBody(NULL, image, this->table.ptr<uchar>()));
+    else
+        cv::parallel_for_(cv::Range(0, stripes), ConversionBody(image, this->codes));
+}
+
+// Gray chain on an already computed (e.g. equalized) gray plane: image = table[gray]
+void ColorChain::applyToGray(const cv::Mat &gray, cv::Mat &image) const{
+    CV_Assert(this->gray && gray.type()==CV_8U);
+    image.create(gray.size(), CV_8UC3);
+    int stripes = (image.rows+STRIPE_ROWS-1)/STRIPE_ROWS;
+    cv::parallel_for_(cv::Range(0, stripes), GrayTableBody(&gray, image, this->table.ptr<uchar>()));
+}
@@ -0,0 +1,40 @@
+/*
+    @file: colorchain.h
+    @license: GNU General Public License
+    @author: Juan Manuel Perez Rua
+    @note: Code written for th practical module of
+    Visual Perception at the Université de Bourgogne
+*/
+
+#ifndef COLORCHAIN_H
+#define COLORCHAIN_H
+
+#include <vector>
+#include "opencv2/opencv.hpp"
+
+// The gray conversion and the colorspace conversions enabled in the GUI,
+// composed once when the pipeline is built. Each conversion treats the
+// output of the previous one as BGR, like the chained in-place cvtColor
+// calls did, but the whole chain runs in one pass over the frame:
+//  - after a gray conversion every pixel is (g,g,g), so whatever follows
+//    only depends on g and the chain collapses into a 256 entry table of
+//    BGR triplets (gray alone is the identity table, which removes the
+//    BGR->GRAY->BGR round trip);
+//  - otherwise the conversions are run back to back on stripes of rows,
+//    in parallel, so each stripe stays in cache for the whole chain.
+class ColorChain{
+public:
+    enum{ STRIPE_ROWS=32 };
+    ColorChain();
+    void build(bool gray, const std::vector<int> &codes);
+    bool isGrayChain() const;
+    int size() const;
+    void apply(cv::Mat &image) const;
+    void applyToGray(const cv::Mat &gray, cv::Mat &image) const;
+private:
+    bool gray;
+    std::vector<int> codes;
+    cv::Mat table;  // 1x256 CV_8UC3, chain output for (g,g,g)
+};
+
+#endif // COLORCHAIN_H
@@ -0,0 +1,212 @@
+/*
+    @file: componentlabeller.cpp
+    @license: GNU General Public License
+    @author: Juan Manuel Perez Rua
+    @note: Code written for th practical module of
+    Visual Perception at the Université de Bourgogne
+*/
+
+#include "componentlabeller.h"
+#include <algorithm>
+
+/* Runs of consecutive rows touch, diagonals included */
+static bool touching(const ComponentLabeller::Run &a, const ComponentLabeller::Run &b){
+    return b.start<=a.end+1 && a.start<=b.end+1;
+}
+
+static int findRoot(std::vector<int> &parent, int i){
+    while (parent[i]!=i){
+        parent[i] = parent[parent[i]];
+        i = parent[i];
+    }
+    return i;
+}
+
+static void join(std::vector<int> &parent, int a, int b){
+    a = findRoot(parent, a);
+    b = findRoot(parent, b);
+    if (a<b) parent[b]=a;
+    else if (b<a) parent[a]=b;
+}
+
+/* Join the runs [prev, prevEnd) of one row with the runs [cur, curEnd) of the next */
+static void joinRows(const std::vector<ComponentLabeller::Run> &runs, std::vector<int> &parent,
+                     int prev, int prevEnd, int cur, int curEnd){
+    while (prev<prevEnd && cur<curEnd){
+        if (touching(runs[prev], runs[cur]))
+            join(parent, prev, cur);
+        // Advance whichever run ends first, it cannot touch anything further right
+        if (runs[prev].end<runs[cur].end)
+            prev++;
+        else
+            cur++;
+    }
+}
+
+class RunBody : public cv::ParallelLoopBody{
+public:
+    RunBody(ComponentLabeller *labeller, bool join) : labeller(labeller), joinRuns(join){}
+    void operator()(const cv::Range &range) const{
+        for (int s=range.start; s<range.end; s++){
+            if (!this->joinRuns){
+                this->labeller->extractStripe(s);
+                continue;
+            }
+            // Each stripe only touches the parent entries of its own runs
+            const std::vector<ComponentLabeller::Run> &runs = this->labeller->runs;
+            int first = this->labeller->stripeOffset[s], last = this->labeller->stripeOffset[s+1];
+            int prev=first, prevEnd=first;
+            for (int i=first; i<last;){
+                int row = runs[i].row, rowEnd=i;
+                while (rowEnd<last && runs[rowEnd].row==row)
+                    rowEnd++;
+                if (prevEnd>prev && runs[prev].row==row-1)
+                    joinRows(runs, this->labeller->parent, prev, prevEnd, i, rowEnd);
+                prev=i;
+                prevEnd=rowEnd;
+                i=rowEnd;
+            }
+        }
+    }
+private:
+    ComponentLabeller *labeller;
+    bool joinRuns;
+};
+
+ComponentLabeller::ComponentLabeller(){
+    this->binary=NULL;
+    this->stripes=0;
+    this->stripeRows=0;
+}
+
+void ComponentLabeller::extractStripe(int stripe){
+    std::vector<Run> &out = this->stripeRuns[stripe];
+    out.clear();
+    int end = std::min(this->binary->rows, (stripe+1)*this->stripeRows);
+    for (int r=stripe*this->stripeRows; r<end; r++){
+        const uchar *p = this->binary->ptr<uchar>(r);
+        int cols = this->binary->cols;
+        for (int x=0; x<cols;){
+            while (x<cols && p[x]==0)
+                x++;
+            if (x==cols)
+                break;
+            Run run;
+            run.row=r;
+            run.start=x;
+            while (x<cols && p[x]!=0)
+                x++;
+            run.end=x-1;
+            out.push_back(run);
+        }
+    }
+}
+
+int ComponentLabeller::find(int run){
+    return findRoot(this->parent, run);
+}
+
+// Label the non-zero pixels of a CV_8U plane
+const std::vector<Component> &ComponentLabeller::analyze(const cv::Mat &binary, bool circles){
+    CV_Assert(binary.type()==CV_8U);
+    this->binary=&binary;
+    this->size=binary.size();
+    this->stripes = std::max(1, std::min(4*cv::getNumThreads(), binary.rows/32));
+    this->stripeRows = (binary.rows+this->stripes-1)/this->stripes;
+    this->stripeRuns.resize(this->stripes);
+
+    /* Pass 1: runs and local unions, stripe by stripe in parallel */
+    cv::parallel_for_(cv::Range(0, this->stripes), RunBody(this, false));
+    this->stripeOffset.resize(this->stripes+1);
+    this->runs.clear();
+    for (int s=0; s<this->stripes; s++){
+        this->stripeOffset[s] = this->runs.size();
+        this->runs.insert(this->runs.end(), this->stripeRuns[s].begin(), this->stripeRuns[s].end());
+    }
+    this->stripeOffset[this->stripes] = this->runs.size();
+    int n = this->runs.size();
+    this->parent.resize(n);
+    for (int i=0; i<n; i++)
+        this->parent[i]=i;
+    cv::parallel_for_(cv::Range(0, this->stripes), RunBody(this, true));
+
+    /* Stripe borders: last row of a stripe against the first row of the next */
+    for (int s=1; s<this->stripes; s++){
+        int cur = this->stripeOffset[s], curEnd = this->stripeOffset[s+1];
+        int prevEnd = cur, prev = cur;
+        if (cur==curEnd || prev==0)
+            continue;
+        while (prev>0 && this->runs[prev-1].row==this->runs[cur-1].row)
+            prev--;
+        if (this->runs[prev].row!=this->runs[cur].row-1)
+            continue;
+        int rowEnd=cur;
+        while (rowEnd<curEnd && this->runs[rowEnd].row==this->runs[cur].row)
+            rowEnd++;
+        joinRows(this->runs, this->parent, prev, prevEnd, cur, rowEnd);
+    }
+
+    /* Pass 2: number the components and accumulate their statistics */
+    this->componentOf.resize(n);
+    this->components.clear();
+    std::vector<double> sumX, sumY;
+    std::vector< std::vector<cv::Point> > ends;
+    for (int i=0; i<n; i++){
+        const Run &run = this->runs[i];
+        int root = find(i);
+        int c;
+        if (root==i){
+            c = this->components.size();
+            Component component;
+            component.area=0;
+            component.box = cv::Rect(run.start, run.row, 0, 0);
+            component.radius=0;
+            this->components.push_back(component);
+            sumX.push_back(0);
+            sumY.push_back(0);
+            if (circles)
+                ends.push_back(std::vector<cv::Point>());
+        }else
+            c = this->componentOf[root];
+        this->componentOf[i]=c;
+
+        Component &component = this->components[c];
+        int length = run.end-run.start+1;
+        component.area += length;
+        sumX[c] += 0.5*(run.start+run.end)*length;
+        sumY[c] += double(run.row)*length;
+        // box holds x1,y1 and x2,y2 until the end
+        component.box.x = std::min(component.box.x, run.start);
+        component.box.width = std::max(component.box.width, run.end);
+        component.box.height = run.row;
+        if (circles){
+            ends[c].push_back(cv::Point(run.start, run.row));
+            if (run.end!=run.start)
+                ends[c].push_back(cv::Point(run.end, run.row));
+        }
+    }
+    for (unsigned int c=0; c<this->components.size(); c++){
+        Component &component = this->components[c];
+        component.box.width = component.box.width-component.box.x+1;
+        component.box.height = component.box.height-component.box.y+1;
+        component.centroid = cv::Point2f(sumX[c]/component.area, sumY[c]/component.area);
+        component.center = component.centroid;
+        if (circles)
+            cv::minEnclosingCircle(cv::Mat(ends[c]), component.center, component.radius);
+    }
+    return this->components;
+}
+
+const std::vector<Component> &ComponentLabeller::getComponents() const{
+    return this->components;
+}
+
+// Label image of the last analyze(): CV_32S, 0 background, i+1 for component i
+void ComponentLabeller::paintLabels(cv::Mat &labels) const{
+    labels.create(this->size, CV_32S);
+    labels.setTo(cv::Scalar(0));
+    for (unsigned int i=0; i<this->runs.size(); i++){
+        int *row = labels.ptr<int>(this->runs[i].row);
+        std::fill(row+this->runs[i].start, row+this->runs[i].end+1, this->componentOf[i]+1);
+    }
+}
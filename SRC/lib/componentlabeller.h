@@ -0,0 +1,56 @@
+/*
+    @file: componentlabeller.h
+    @license: GNU General Public License
+    @author: Juan Manuel Perez Rua
+    @note: Code written for th practical module of
+    Visual Perception at the Université de Bourgogne
+*/
+
+#ifndef COMPONENTLABELLER_H
+#define COMPONENTLABELLER_H
+
+#include <vector>
+#include "opencv2/opencv.hpp"
+
+// One 8-connected blob of non-zero pixels
+struct Component{
+    int area;               // pixels
+    cv::Rect box;           // bounding box
+    cv::Point2f centroid;
+    cv::Point2f center;     // minimum enclosing circle, only when asked for
+    float radius;
+};
+
+// Connected components of a binary plane with their statistics, without
+// tracing contours. The plane is cut in stripes of rows; each stripe turns
+// its rows into runs of foreground pixels and joins overlapping runs of
+// consecutive rows with a union-find, in parallel. The stripe borders are
+// then joined and every run gets its component, numbered in raster order.
+// Boxes, centroids and areas come from the runs in the same sweep; the
+// enclosing circles from the run end points, which hold every convex hull
+// vertex, so they match minEnclosingCircle over the outer contour.
+class ComponentLabeller{
+public:
+    struct Run{
+        int row, start, end; // end inclusive
+    };
+    ComponentLabeller();
+    const std::vector<Component> &analyze(const cv::Mat &binary, bool circles);
+    const std::vector<Component> &getComponents() const;
+    void paintLabels(cv::Mat &labels) const;
+private:
+    friend class RunBody;
+    void extractStripe(int stripe);
+    int find(int run);
+    const cv::Mat *binary;
+    int stripes, stripeRows;
+    std::vector< std::vector<Run> > stripeRuns;
+    std::vector<int> stripeOffset;  // index of the first run of each stripe
+    std::vector<Run> runs;
+    std::vector<int> parent;        // union-find over runs, roots are the smallest index
+    std::vector<int> componentOf;   // run -> component
+    std::vector<Component> components;
+    cv::Size size;
+};
+
+#endif // COMPONENTLABELLER_H
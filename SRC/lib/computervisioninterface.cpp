@@ -21,53 +21,22 @@
 
 /* Interface Global Variables */
 
-QImage qImage1;
-QImage qImage1Histogram;
-QImage qProccessedImage;
 double FM[3][3]={{0,0,0},{0,0,0},{0,0,1}};
 double HG[3][3]={{0,0,0},{0,0,0},{0,0,1}};
 double EC[3][3]={{0,0,0},{0,0,0},{0,0,1}};
 std::vector<cv::Point3d> structure;
 std::vector<cv::Vec3b> colors;
 
-ComputerVisionInterface::ComputerVisionInterface(){
-    this->addSaltPepperNoise=false;
-    this->addGaussianNoise=false;
-    this->noisePower=50;/*min=0, max=99*/
-    this->noiseStdDev=50;/*min=0, max=99*/
-    this->convertToGray=false;
+ComputerVisionInterface::ComputerVisionInterface() : stream(&settings){
+    this->stream.setProfiler(&this->profiler);
     this->updateHistogram=false;
-    this->equalizeHistogram=false;
-    this->rgbToHls=false;
-    this->rgbToHsv=false;
-    this->rgbToXyz=false;
-    this->rgbToYcbcr=false;
-    this->rgbToLab=false;
-    this->rgbToLuv=false;
-    this->logoActivated=false;
-    this->logoFilename="";
-    this->transparency=50;
     this->workingOnCam=false;
     this->workingOnFrame=false;
     this->workingOnVideo=false;
     this->setLoopLock(true);
     this->endVideo=false;
-    this->morpho="NONE";
-    this->filter="NONE";
-    this->hough="NONE";
-    this->shape="NONE";
-    this->feature="NONE";
-    this->stereo = "NONE";
-    this->fundamentalMethod="NONE";
-    this->featureParam=50;
-    this->filterParam=50;
-    this->morphoSize=3;
-    this->canny=false;
-    this->cannyParam1=50;
-    this->cannyParam2=50;
-    this->conObjs = false;
-    this->threshold=50;
-    this->contours=false;
+    this->stereo=STEREO_NONE;
+    this->fundamentalMethod=-1;
     this->bmview1=false;
     this->bmview2=false;
     this->calibrate=false;
@@ -81,6 +50,12 @@ ComputerVisionInterface::ComputerVisionInterface(){
     this->addImageToSFM=false;
     this->addImageToSFMFF=false;
     this->addImageToStitchFF=false;
+    this->frameChannel=NULL;
+    this->matcher.setConfidenceLevel(0.98);
+    this->matcher.setMinDistanceToEpipolar(1.0);
+    this->matcher.setRatio(0.65f);
+    this->stereoFeature=DETECTOR_SURF;
+    configureMatcher(DETECTOR_SURF);
 }
 
 ComputerVisionInterface::~ComputerVisionInterface(){
@@ -95,44 +70,46 @@ void ComputerVisionInterface::process(){
 void ComputerVisionInterface::computerVisionMachine(void){
     cv::Mat frame;
     cv::Mat proccessedImage;
+    QImage qImage1;
+    QImage qImage1Histogram;
+    QImage qProccessedImage;
 
-    if (this->workingOnCam){
-        this->endVideo=false;
-        setVideoCapturer1(CV_CAP_ANY);
-    }
-
-    if (this->workingOnVideo){
-        this->endVideo=false;
-        this->capture1.open(this->videoFilename);
-        //std::cout<<this->videoFilename<<std::endl;
-    }
+    FramePacket packet;
 
     while(this->loopLocked){
-        if (this->workingOnCam){
-            /* Capture Image from camera1 and convert to QImage */
-            //capture1 >> frame is also possible
-
-            if (!capture1.grab() || !capture1.retrieve(frame) ){
+        /* The GUI selects the source right after starting the thread */
+        if (!this->stream.isRunning()){
+            bool opened=false;
+            if (this->workingOnCam)
+                opened = this->source.openCamera(CV_CAP_ANY);
+            else if (this->workingOnVideo)
+                opened = this->source.openVideo(this->videoFilename);
+            else if (this->workingOnFrame)
+                opened = this->source.openImage(this->frameFilename);
+            else{
+                QTest::qSleep(10);
+                continue;
+            }
+            if (!opened){
                 std::cout<<"Video Stopped"<<std::endl;
                 this->endVideo = true;
+                break;
             }
-            qImage1 = Mat2QImage(frame);
-            proccessedImage = frame.clone();
+            this->endVideo=false;
+            this->stream.start(&this->source);
         }
-        if (this->workingOnVideo){
-            if (!capture1.grab() || !capture1.retrieve(frame) ){
+
+        /* Capture and the processing chain run on their own threads */
+        if (!this->stream.next(packet, 100)){
+            if (this->stream.isFinished() && !this->endVideo){
                 std::cout<<"Video Stopped"<<std::endl;
                 this->endVideo = true;
             }
-            qImage1 = Mat2QImage(frame);
-            proccessedImage = frame.clone();
-        }
-        if (this->workingOnFrame){
-            frame = cv::imread(this->frameFilename, CV_LOAD_IMAGE_COLOR);
-            qImage1 = Mat2QImage(frame);
-            proccessedImage = frame.clone();
-            QTest::qSleep(100);
+            continue;
         }
+        frame = packet.frame;
+        proccessedImage = packet.processed;
+        qImage1 = originalConverter.convert(frame);
 
         /* Start asking about proccessing options */
         if (this->bmview1){
@@ -145,273 +122,13 @@ void ComputerVisionInterface::computerVisionMachine(void){
             this->bmview2=false;
         }
 
-        if (this->logoActivated){
-            cv::Mat logo, rlogo;
-            logo = cv::imread(this->logoFilename, CV_LOAD_IMAGE_COLOR);
-            cv::resize(logo, rlogo, cv::Size(proccessedImage.cols/5, proccessedImage.rows/5),CV_INTER_LINEAR);
-            cv::Rect roi = cv::Rect( (proccessedImage.cols-rlogo.cols)*(this->xlogo/100),
-                                     (proccessedImage.rows-rlogo.rows)*(this->ylogo/100),
-                                    rlogo.cols,
-                                    rlogo.rows );
-            cv::Mat subView = proccessedImage(roi);
-            cv::addWeighted(rlogo,1-(double)this->transparency/100,subView,(double)this->transparency/100,0,subView);
-            //rlogo.copyTo(subView);
-        }
 
-        if (this->addSaltPepperNoise){
-            cv::Mat saltedMatrix = cv::Mat::zeros(proccessedImage.rows, proccessedImage.cols, CV_8U);
-            cv::randu(saltedMatrix, 0, 255);
-            cv::Mat black = saltedMatrix < (127*double(noisePower)/100);
-            cv::Mat white = saltedMatrix > (255-127*double(noisePower)/100);
-            proccessedImage.setTo(255,white);
-            proccessedImage.setTo(0,black);
-        }
-        if (this->addGaussianNoise){
-            cv::Mat noisedMatrix = proccessedImage.clone();
-            cv::randn(noisedMatrix,int(double(noisePower)/2),255*noiseStdDev/100);
-            double maxVal1, maxVal2;
-            cv::minMaxLoc(noisedMatrix, NULL, &maxVal1, NULL, NULL);
-            cv::minMaxLoc(proccessedImage, NULL, &maxVal2, NULL, NULL);
-            cv::addWeighted(noisedMatrix, 255/(maxVal1+maxVal2), proccessedImage, 255/(maxVal2+maxVal1), 0, proccessedImage);
-        }
-        if (this->convertToGray){
-            cv::Mat gray;
-            cv::cvtColor(proccessedImage, gray, CV_BGR2GRAY);
-            cv::cvtColor(gray,proccessedImage, CV_GRAY2BGR);
-        }
-        if (this->equalizeHistogram){
-            cv::Mat gray, equalizedBuffer;
-            cv::cvtColor(proccessedImage, gray, CV_BGR2GRAY);
-            cv::equalizeHist(gray, equalizedBuffer);
-            cv::cvtColor(equalizedBuffer,proccessedImage, CV_GRAY2BGR);
-        }
-        if (this->rgbToHls){
-            cv::cvtColor(proccessedImage, proccessedImage, CV_BGR2HLS);
-        }
-        if (this->rgbToHsv){
-            cv::cvtColor(proccessedImage, proccessedImage, CV_BGR2HSV);
-        }
-        if (this->rgbToYcbcr){
-            cv::cvtColor(proccessedImage, proccessedImage, CV_BGR2YCrCb);
-        }
-        if (this->rgbToXyz){
-            cv::cvtColor(proccessedImage, proccessedImage, CV_BGR2XYZ);
-        }
-        if (this->rgbToLuv){
-            cv::cvtColor(proccessedImage, proccessedImage, CV_BGR2Luv);
-        }
-        if (this->rgbToLab){
-            cv::cvtColor(proccessedImage, proccessedImage, CV_BGR2Lab);
-        }
-        if (morpho.compare("NONE",Qt::CaseSensitive)!=0){
-            if (morpho.compare("OPEN")==0){
-                cv::morphologyEx(proccessedImage, proccessedImage, cv::MORPH_CLOSE, cv::Mat(this->morphoSize,this->morphoSize,CV_8U,cv::Scalar(1)));
-            }else if (morpho.compare("CLOSE")==0){
-                cv::morphologyEx(proccessedImage, proccessedImage, cv::MORPH_CLOSE, cv::Mat(this->morphoSize,this->morphoSize,CV_8U,cv::Scalar(1)));
-            }else if (morpho.compare("DILATE")==0){
-                cv::dilate(proccessedImage, proccessedImage,cv::Mat(this->morphoSize,this->morphoSize,CV_8U,cv::Scalar(1)));
-            }else if (morpho.compare("ERODE")==0){
-                cv::erode(proccessedImage, proccessedImage,cv::Mat(this->morphoSize,this->morphoSize,CV_8U,cv::Scalar(1)));
-            }
-        }
-        if (filter.compare("NONE",Qt::CaseSensitive)!=0){
-            if (filter.compare("BLUR")==0){
-                cv::blur(proccessedImage, proccessedImage, cv::Size(50*this->filterParam/100+1,50*this->filterParam/100+1));
-            }else if (filter.compare("SHARP")==0){
-                cv::Mat image;
-                int size = this->filterParam; if (size%2==0)size++;
-                cv::GaussianBlur(proccessedImage, image, cv::Size(size,size),75);
-                cv::addWeighted(proccessedImage, 1.5, image, -0.5, 0, proccessedImage);
-            }else if (filter.compare("SOBEL")==0){
-                int size=0;
-                if (this->filterParam<33) size=3;
-                else if (this->filterParam<66) size=5;
-                else if (this->filterParam<100) size=7;
-                cv::Sobel(proccessedImage, proccessedImage, proccessedImage.depth(),1,1, size );
-            }else if (filter.compare("LAPLACIAN")==0){
-                int size = 31*this->filterParam/100; if (size%2==0)size++;
-                cv::Laplacian(proccessedImage, proccessedImage, proccessedImage.depth(),size);
-            }
-        }
-        if (this->canny){
-            cv::Canny(proccessedImage, proccessedImage, this->cannyParam1, this->cannyParam2);
-            cv::cvtColor(proccessedImage,proccessedImage, CV_GRAY2BGR);
-        }
-        if (hough.compare("NONE",Qt::CaseSensitive)!=0){
-            if (hough.compare("LINES")==0){
-                cv::Mat gray, buffer;
-                cv::Canny(proccessedImage, buffer, this->cannyParam1, this->cannyParam2);
-                cv::cvtColor(buffer, buffer, CV_GRAY2BGR);
-                std::vector<cv::Vec4i> lines;
-                cv::cvtColor(buffer, gray, CV_BGR2GRAY);
-                cv::HoughLinesP(gray, lines, 1, CV_PI/180, this->houghParam+1,30,5);
-                for (unsigned int i=0; i<lines.size();i++){
-                    cv::Vec4i li = lines[i];
-                    cv::line(proccessedImage, cv::Point(li[0],li[1]),
-                             cv::Point(li[2],li[3]), cv::Scalar(255,255,0),
-                             3, CV_AA);
-                }
-            }else if (hough.compare("CIRCLES")==0){
-                cv::Mat gray;
-                if (proccessedImage.depth()==frame.depth())
-                    cv::cvtColor(proccessedImage, gray, CV_BGR2GRAY);
-                else
-                    gray = proccessedImage;
-                std::vector<cv::Vec3f> circles;
-                cv::HoughCircles( gray, circles, CV_HOUGH_GRADIENT,1, this->houghParam+1,
-                                  this->cannyParam1+1, this->cannyParam2+1, 0, 0 );
-
-                for (unsigned int i=0; i<circles.size();i++){
-                    cv::Point cen(cvRound(circles[i][0]),cvRound(circles[i][1]));
-                    int rad = cvRound(circles[i][2]);
-                    cv::circle( proccessedImage, cen, 3, cv::Scalar(0,0,255), -1, 8, 0 );
-                    cv::circle( proccessedImage, cen, rad, cv::Scalar(255,0,0), 3, 8, 0 );
-                }
-            }
-        }
-        if (this->conObjs){
-            cv::Mat gray;
-            cv::cvtColor(proccessedImage, gray, CV_BGR2GRAY);
-            std::vector< std::vector<cv::Point> > contours;
-
-            cv::threshold(gray, gray, 255*this->threshold/100, 255, CV_THRESH_BINARY);
-            cv::cvtColor(gray,proccessedImage, CV_GRAY2BGR);
-            cv::findContours(gray, contours, CV_RETR_EXTERNAL, CV_CHAIN_APPROX_NONE);
-            cv::drawContours(proccessedImage, contours, -1/*Draw all contours*/, cv::Scalar(255,255,255),10);
-        }
-        if (this->contours){
-            cv::Mat buffer;
-            std::vector< std::vector<cv::Point> > contours;
-            cv::cvtColor(proccessedImage, buffer, CV_BGR2GRAY);
-            cv::threshold(buffer, buffer, 255*this->threshold/100, 255, CV_THRESH_BINARY);
-            cv::findContours(buffer, contours, CV_RETR_EXTERNAL, CV_CHAIN_APPROX_NONE);
-            cv::drawContours(proccessedImage, contours, -1/*Draw all contours*/, cv::Scalar(255,255,0),2);
-        }
-        if (shape.compare("NONE",Qt::CaseSensitive)!=0){
-            if (shape.compare("BOX")==0){
-                cv::Mat buffer;
-                std::vector< std::vector<cv::Point> > contours;
-                cv::cvtColor(proccessedImage, buffer, CV_BGR2GRAY);
-                cv::threshold(buffer, buffer, 255*this->threshold/100, 255, CV_THRESH_BINARY);
-                cv::findContours(buffer, contours, CV_RETR_EXTERNAL, CV_CHAIN_APPROX_NONE);
-
-                for (unsigned int i=0; i<contours.size(); i++){
-                    cv::Rect boxi = cv::boundingRect(cv::Mat(contours[i]));
-                    cv::rectangle(proccessedImage, boxi, cv::Scalar(0,0,255),3);
-                }
-            }else if (shape.compare("CIRCLE")==0){
-                cv::Mat buffer;
-                std::vector< std::vector<cv::Point> > contours;
-                cv::cvtColor(proccessedImage, buffer, CV_BGR2GRAY);
-                cv::threshold(buffer, buffer, 255*this->threshold/100, 255, CV_THRESH_BINARY);
-                cv::findContours(buffer, contours, CV_RETR_EXTERNAL, CV_CHAIN_APPROX_NONE);
-
-                for (unsigned int i=0; i<contours.size(); i++){
-                    float rad;
-                    cv::Point2f cen;
-                    cv::minEnclosingCircle(cv::Mat(contours[i]), cen, rad);
-                    cv::circle(proccessedImage, cen, rad, cv::Scalar(0,0,255),3);
-                }
-            }else if (shape.compare("CENTER")==0){
-                cv::Mat buffer;
-                std::vector< std::vector<cv::Point> > contours;
-                cv::cvtColor(proccessedImage, buffer, CV_BGR2GRAY);
-                cv::threshold(buffer, buffer, 255*this->threshold/100, 255, CV_THRESH_BINARY);
-                cv::findContours(buffer, contours, CV_RETR_EXTERNAL, CV_CHAIN_APPROX_NONE);
-
-                for (unsigned int i=0; i<contours.size(); i++){
-                    float rad;
-                    cv::Point2f cen;
-                    cv::minEnclosingCircle(cv::Mat(contours[i]), cen, rad);
-                    cv::circle(proccessedImage, cen, 3, cv::Scalar(0,0,255),3);
-                }
-            }
-        }
-
-        if (feature.compare("NONE",Qt::CaseSensitive)!=0){
-            if (feature.compare("MSER")==0){
-                cv::Mat gray;
-                std::vector< std::vector< cv::Point > > keys;
-                cv::cvtColor(proccessedImage, gray, CV_BGR2GRAY);
-                cv::MSER mserDet;
-                mserDet.operator ()(gray, keys, cv::Mat());
-                cv::drawContours(proccessedImage, keys, -1/*Draw all contours*/, cv::Scalar(255,0,0),2);
-
-            }else if (feature.compare("HARRIS")==0){
-                // Detect Harris Corner
-                cv::Mat gray, norm;
-                int thresh=255*this->featureParam/100;
-                cv::cvtColor(proccessedImage, gray, CV_BGR2GRAY);
-                cv::cornerHarris(gray,gray,100,3,0.04 /*Harris parameter*/);
-
-                /// Normalizing
-                cv::normalize( gray, norm, 0, 255, cv::NORM_MINMAX, CV_32FC1, cv::Mat() );
-
-                /// Drawing a circle around corners
-                for( int j = 0; j < norm.rows ; j++ ){
-                    for( int i = 0; i < norm.cols; i++ ){
-                      if( (int) norm.at<float>(j,i) > thresh ){
-                        cv::circle( proccessedImage, cv::Point(i,j), 1,  cv::Scalar(255,255,0), 1);
-                      }
-                    }
-                }
-            }else if (feature.compare("HARRIS_NMS")==0){
-                cv::Mat gray;
-                cv::cvtColor(proccessedImage, gray, CV_BGR2GRAY);
-
-                std::vector< cv::Point > strong_corners;
-                cv::goodFeaturesToTrack(gray, strong_corners, 100, this->featureParam/100+0.05, 7, cv::noArray(), 3, true, 0.04);
-                for (unsigned int i=0; i<strong_corners.size(); i++){
-                    cv::circle( proccessedImage, strong_corners[i], 3,  cv::Scalar(255,0,255), 2);
-                }
-            }else if (feature.compare("STAR")==0){
-                cv::Mat gray;
-                std::vector< cv::KeyPoint > keys;
-                cv::StarDetector starDet(5, 10*this->featureParam/100, 5, 5, 10);
-                cv::cvtColor(proccessedImage, gray, CV_BGR2GRAY);
-                starDet.detect(gray, keys);
-                cv::drawKeypoints(proccessedImage, keys, proccessedImage, cv::Scalar(0,255,255));
-            }else if (feature.compare("FAST")==0){
-                cv::Mat gray;
-                std::vector< cv::KeyPoint > keys;
-                cv::cvtColor(proccessedImage, gray, CV_BGR2GRAY);
-                cv::FAST(gray, keys, 100*this->featureParam/255, true);
-                cv::drawKeypoints(proccessedImage, keys, proccessedImage, cv::Scalar(255,0,0));
-            }else if (feature.compare("SIFT")==0){
-                cv::Mat gray;
-                std::vector< cv::KeyPoint > keys;
-                cv::cvtColor(proccessedImage, gray, CV_BGR2GRAY);
-                cv::SIFT sifter(1, this->featureParam+1, 0.04, 10, 1.6);
-                sifter.detect(gray, keys);
-                cv::drawKeypoints(proccessedImage, keys, proccessedImage, cv::Scalar(0,0,255));
-            }else if (feature.compare("SURF")==0){
-                cv::Mat gray;
-                std::vector< cv::KeyPoint > keys;
-                cv::cvtColor(proccessedImage, gray, CV_BGR2GRAY);
-                cv::SURF surfer(255*this->featureParam/100+1);
-                surfer.detect(gray, keys);
-                cv::drawKeypoints(proccessedImage, keys, proccessedImage, cv::Scalar(0,255,0));
-            }
-        }
-
-        if (fundamentalMethod.compare("NONE",Qt::CaseSensitive)!=0){
-            RobustMatcher rmatcher;
-            rmatcher.setConfidenceLevel(0.98);
-            rmatcher.setMinDistanceToEpipolar(1.0);
-            rmatcher.setRatio(0.65f);
-            cv::Ptr<cv::FeatureDetector> pfd=new cv::SurfFeatureDetector(10);
-            rmatcher.setFeatureDetector(pfd);
-
-            if (fundamentalMethod.compare("7POINT")==0){
-                rmatcher.setMethod(CV_FM_7POINT);
-                F = rmatcher.match(this->mview1,this->mview2,this->matches, this->keypoints1, this->keypoints2);
-            }else if (fundamentalMethod.compare("8POINT")==0){
-                rmatcher.setMethod(CV_FM_8POINT);
-                F = rmatcher.match(this->mview1,this->mview2,this->matches, this->keypoints1, this->keypoints2);
-            }else if (fundamentalMethod.compare("RANSAC")==0){
-                rmatcher.setMethod(CV_FM_RANSAC);
-                F = rmatcher.match(this->mview1,this->mview2,this->matches, this->keypoints1, this->keypoints2);
-            }
+        if (this->fundamentalMethod>=0){
+            ScopedTimer timer(&this->profiler, PROFILE_STEREO);
+            if (this->stereoFeature!=this->matcherFeature)
+                configureMatcher((DetectorKind)this->stereoFeature);
+            this->matcher.setMethod(this->fundamentalMethod);
+            F = this->matcher.match(this->mview1,this->mview2,this->matches, this->keypoints1, this->keypoints2);
 
             FM[0][0] = F.at<double>(0,0);
             FM[0][1] = F.at<double>(0,1);
@@ -422,10 +139,11 @@ void ComputerVisionInterface::computerVisionMachine(void){
             FM[2][0] = F.at<double>(2,0);
             FM[2][1] = F.at<double>(2,1);
             FM[2][2] = F.at<double>(2,2);
-            fundamentalMethod="NONE";
+            this->fundamentalMethod=-1;
         }
 
-        if (stereo.compare("NONE",Qt::CaseSensitive)!=0){
+        if (this->stereo!=STEREO_NONE){
+            ScopedTimer timer(&this->profiler, PROFILE_STEREO);
             //Convert Keypoints
             std::vector<cv::Point2f> points1, points2;
             for (std::vector<cv::DMatch>::const_iterator it= matches.begin();it!= matches.end(); ++it) {
@@ -439,7 +157,7 @@ void ComputerVisionInterface::computerVisionMachine(void){
                 points2.push_back(cv::Point2f(x,y));
             }
 
-            if (stereo.compare("EPIPOLAR")==0){
+            if (this->stereo==STEREO_EPIPOLAR){
                 std::vector<cv::Vec3f> lines;
                 std::vector<cv::Point2f> points;
 
@@ -466,7 +184,7 @@ void ComputerVisionInterface::computerVisionMachine(void){
                 for (unsigned int i=0; i<points.size();i++){
                     cv::circle(proccessedImage, points[i],3, cv::Scalar(255,255,0));
                 }
-            }else if (stereo.compare("HOMOGRAPHY")==0){
+            }else if (this->stereo==STEREO_HOMOGRAPHY){
                 std::vector<cv::Point2f> points1, points2;
                 for (std::vector<cv::DMatch>::const_iterator it= matches.begin();it!= matches.end(); ++it) {
                     // Get the position of left keypoints
@@ -518,7 +236,7 @@ void ComputerVisionInterface::computerVisionMachine(void){
                 HG[2][0] = H.at<double>(2,0);
                 HG[2][1] = H.at<double>(2,1);
                 HG[2][2] = H.at<double>(2,2);
-            }else if (stereo.compare("MOSAIC")==0){
+            }else if (this->stereo==STEREO_MOSAIC){
                 // Warp image 1 to image 2
                 cv::Mat result;
                 cv::warpPerspective(this->mview1,result,H,cv::Size(2*this->mview1.cols,this->mview1.rows));
@@ -526,12 +244,13 @@ void ComputerVisionInterface::computerVisionMachine(void){
                 cv::Mat half(result,cv::Rect(0,0,this->mview2.cols,this->mview2.rows));
                 this->mview2.copyTo(half); // copy image2 to image1 roi
                 result.copyTo(proccessedImage);
-            }else if (stereo.compare("MATCHES")==0){
+            }else if (this->stereo==STEREO_MATCHES){
                 cv::drawMatches(this->mview1, this->keypoints1, this->mview2, this->keypoints2, this->matches,
                                 proccessedImage);
             }
         }
         if (this->calibrate){
+            ScopedTimer timer(&this->profiler, PROFILE_CALIBRATION);
             if (this->calibImageIndex<this->numImagesCalibration){
                 if (calibrator.addChessboardPoints(proccessedImage, cv::Size(9,6)) > 0)
                     this->calibImageIndex++;
@@ -558,7 +277,7 @@ void ComputerVisionInterface::computerVisionMachine(void){
         if (this->addImageToStitch){
             this->addImageToStitch=false;
             this->addImageToStitchFF=false;
-            this->stitchImages.push_back(proccessedImage);
+            this->stitchImages.push_back(proccessedImage.clone());
         }
 
         if (this->addImageToStitchFF){
@@ -569,6 +288,7 @@ void ComputerVisionInterface::computerVisionMachine(void){
         }
 
         if (this->stitch){
+            ScopedTimer timer(&this->profiler, PROFILE_STITCHING);
             cv::Stitcher stitcher = cv::Stitcher::createDefault();
             stitcher.stitch(this->stitchImages, proccessedImage);
         }
@@ -576,7 +296,7 @@ void ComputerVisionInterface::computerVisionMachine(void){
         if (this->addImageToSFM){
             this->addImageToSFM=false;
             this->addImageToSFMFF=false;
-            this->sfmImages.push_back(proccessedImage);
+            this->sfmImages.push_back(proccessedImage.clone());
             char name[200];
             sprintf(name,"image_%d",(int)this->imageIds.size()+1);
             this->imageIds.push_back(name);
@@ -612,13 +332,22 @@ void ComputerVisionInterface::computerVisionMachine(void){
         }
 
         if (this->updateHistogram){
-            cv::Mat histogram;
-            histogram = drawHistogram(proccessedImage);
-            qImage1Histogram = Mat2QImage(histogram);
+            ScopedTimer timer(&this->profiler, PROFILE_HISTOGRAM);
+            // Same bins as the previous frame: keep the plot already converted
+            if (this->histogram.compute(proccessedImage) || qImage1Histogram.isNull())
+                qImage1Histogram = histogramConverter.convert(this->histogram.draw());
         }
 
-        qProccessedImage = Mat2QImage(proccessedImage);
+        if (this->profiler.overlayEnabled())
+            this->profiler.drawOverlay(proccessedImage);
+
+        qProccessedImage = processedConverter.convert(proccessedImage);
+        if (this->frameChannel!=NULL && !qProccessedImage.isNull())
+            this->frameChannel->publish(qImage1, qProccessedImage, qImage1Histogram);
+        this->stream.presented(packet);
     }
+    this->stream.stop();
+    this->source.close();
 }
 
 /* bool lock */
@@ -626,76 +355,102 @@ void ComputerVisionInterface::setLoopLock(bool state){
     this->loopLocked=state;
 }
 
-/** QT-OpenCV interface **/
-QImage ComputerVisionInterface::Mat2QImage(IplImage *input){
-    QImage image(input->width, input->height, QImage::Format_RGB32);
-    uchar* pBits = image.bits();
-    int nBytesPerLine = image.bytesPerLine();
-    for (int n = 0; n < input->height; n++){
-        for (int m = 0; m < input->width; m++){
-            CvScalar s = cvGet2D(input, n, m);
-            QRgb value = qRgb((uchar)s.val[2], (uchar)s.val[1], (uchar)s.val[0]);
+/** Setters **/
+void ComputerVisionInterface::setFrameChannel(FrameChannel *channel){
+    this->frameChannel = channel;
+}
 
-            uchar* scanLine = pBits + n * nBytesPerLine;
-            ((uint*)scanLine)[m] = value;
-        }
-    }
-    return image;
+void ComputerVisionInterface::setProcessingWorkers(int n){
+    this->stream.setWorkers(n);
 }
 
-QImage ComputerVisionInterface::Mat2QImage(cv::Mat &mat){
-    IplImage input(mat);
-    QImage image(input.width, input.height, QImage::Format_RGB32);
-    uchar* pBits = image.bits();
-    int nBytesPerLine = image.bytesPerLine();
-    for (int n = 0; n < input.height; n++){
-        for (int m = 0; m < input.width; m++){
-            CvScalar s = cvGet2D(&input, n, m);
-            QRgb value = qRgb((uchar)s.val[2], (uchar)s.val[1], (uchar)s.val[0]);
+void ComputerVisionInterface::setDropFrames(bool drop){
+    this->stream.setQueuePolicy(drop ? QUEUE_DROP_OLDEST : QUEUE_BLOCK);
+}
 
-            uchar* scanLine = pBits + n * nBytesPerLine;
-            ((uint*)scanLine)[m] = value;
-        }
-    }
-    return image;
+StreamStats ComputerVisionInterface::getStreamStats(){
+    return this->stream.getStats();
+}
+
+void ComputerVisionInterface::setProfilerOverlay(bool active){
+    this->profiler.setOverlay(active);
+}
+
+ProfileSummary ComputerVisionInterface::getProfileSummary(ProfileBlock block){
+    return this->profiler.summary(block);
+}
+
+void ComputerVisionInterface::resetProfiler(){
+    this->profiler.reset();
 }
 
-/** Setters **/
 void ComputerVisionInterface::setIm2Show(int i){
     this->showmview = i;
 }
 
 void ComputerVisionInterface::setFeatureParam(double v){
-    this->featureParam=v;
+    QMutexLocker locker(&this->settings.mutex);
+    this->settings.config.featureParam = v;
+    this->settings.changed();
 }
 
 void ComputerVisionInterface::setThreshold(double v){
-    this->threshold=v;
+    QMutexLocker locker(&this->settings.mutex);
+    this->settings.config.threshold = v;
+    this->settings.changed();
 }
 
 void ComputerVisionInterface::setHoughParams(double h){
     this->setLoopLock(true);
-    this->houghParam=h;
+    QMutexLocker locker(&this->settings.mutex);
+    this->settings.config.houghParam = h;
+    this->settings.changed();
+}
+
+// Keep the lines of the previous frames while the edges still support them
+void ComputerVisionInterface::setHoughTracking(bool active){
+    this->setLoopLock(true);
+    QMutexLocker locker(&this->settings.mutex);
+    this->settings.config.houghTracking = active;
+    this->settings.changed();
+}
+
+// Radius range (0 max: no limit) and pyramid level of the circle search
+void ComputerVisionInterface::setHoughCircleRange(int minRadius, int maxRadius, int pyramidLevel){
+    this->setLoopLock(true);
+    QMutexLocker locker(&this->settings.mutex);
+    this->settings.config.houghMinRadius = minRadius;
+    this->settings.config.houghMaxRadius = maxRadius;
+    this->settings.config.houghPyramid = pyramidLevel;
+    this->settings.changed();
 }
 
 void ComputerVisionInterface::setCannyParams(double c1, double c2){
-    this->cannyParam1=c1;
-    this->cannyParam2=c2;
+    QMutexLocker locker(&this->settings.mutex);
+    this->settings.config.cannyParam1 = c1;
+    this->settings.config.cannyParam2 = c2;
+    this->settings.changed();
 }
 
 void ComputerVisionInterface::setFilterParam(double val/*min=0, max=99*/){
     this->setLoopLock(true);
-    this->filterParam = val;
+    QMutexLocker locker(&this->settings.mutex);
+    this->settings.config.filterParam = val;
+    this->settings.changed();
 }
 
 void ComputerVisionInterface::setNoisePower(int val/*min=0, max=99*/){
     this->setLoopLock(true);
-    this->noisePower = val;
+    QMutexLocker locker(&this->settings.mutex);
+    this->settings.config.noisePower = val;
+    this->settings.changed();
 }
 
 void ComputerVisionInterface::setNoiseStdDev(int val/*min=0, max=99*/){
-     this->setLoopLock(true);
-    this->noiseStdDev = val;
+    this->setLoopLock(true);
+    QMutexLocker locker(&this->settings.mutex);
+    this->settings.config.noiseStdDev = val;
+    this->settings.changed();
 }
 
 bool ComputerVisionInterface::setVideoCapturer1(int device){
@@ -734,41 +489,88 @@ void ComputerVisionInterface::selectView2(bool v){
 }
 
 void ComputerVisionInterface::computeFundamentalMatrix(QString m){
-    this->fundamentalMethod = m;
+    if (m.compare("7POINT")==0)
+        this->fundamentalMethod = CV_FM_7POINT;
+    else if (m.compare("8POINT")==0)
+        this->fundamentalMethod = CV_FM_8POINT;
+    else if (m.compare("RANSAC")==0)
+        this->fundamentalMethod = CV_FM_RANSAC;
+    else
+        this->fundamentalMethod = -1;
+}
+
+/* Features used to match the two views: SURF (default), or ORB and BRISK
+   binary descriptors, fast enough for a live epipolar display */
+void ComputerVisionInterface::setStereoFeature(QString type){
+    if (type.compare("ORB")==0)
+        this->stereoFeature = DETECTOR_ORB;
+    else if (type.compare("BRISK")==0)
+        this->stereoFeature = DETECTOR_BRISK;
+    else
+        this->stereoFeature = DETECTOR_SURF;
+}
+
+// Called from the processing loop, which owns the matcher
+void ComputerVisionInterface::configureMatcher(DetectorKind kind){
+    double param = 10; // SURF hessian threshold
+    if (kind==DETECTOR_ORB)
+        param = 2000;  // features
+    else if (kind==DETECTOR_BRISK)
+        param = 30;    // FAST threshold
+    cv::Ptr<cv::FeatureDetector> pfd=this->detectors.detector(kind, param);
+    cv::Ptr<cv::DescriptorExtractor> pde=this->detectors.extractor(kind, param);
+    this->matcher.setFeatureDetector(pfd);
+    this->matcher.setDescriptorExtractor(pde);
+    this->matcher.setMatcherType(kind==DETECTOR_SURF ? MATCHER_FLANN : MATCHER_HAMMING);
+    this->matcherFeature=kind;
 }
 
 void ComputerVisionInterface::findFeature(QString type){
-    this->feature=type;
+    QMutexLocker locker(&this->settings.mutex);
+    this->settings.config.feature = parseFeatureType(type);
+    this->settings.changed();
 }
 
 void ComputerVisionInterface::findShapeDescriptor(QString type){
-    this->shape=type;
+    QMutexLocker locker(&this->settings.mutex);
+    this->settings.config.shape = parseShapeType(type);
+    this->settings.changed();
 }
 
 void ComputerVisionInterface::findContours(bool v){
-    this->contours=v;
+    QMutexLocker locker(&this->settings.mutex);
+    this->settings.config.contours = v;
+    this->settings.changed();
 }
 
 void ComputerVisionInterface::findConObjs(bool v){
-    this->conObjs=v;
+    QMutexLocker locker(&this->settings.mutex);
+    this->settings.config.conObjs = v;
+    this->settings.changed();
 }
 
 void ComputerVisionInterface::setSaltPepperNoise(bool activated, int power/*min=0, max=99*/){
     this->setLoopLock(true);
-    this->addSaltPepperNoise = activated;
-    this->noisePower = power;
+    QMutexLocker locker(&this->settings.mutex);
+    this->settings.config.addSaltPepperNoise = activated;
+    this->settings.config.noisePower = power;
+    this->settings.changed();
 }
 
 void ComputerVisionInterface::setGaussianNoise(bool activated, int power/*min=0, max=99*/, int stddev/*min=0, max=99*/){
     this->setLoopLock(true);
-    this->addGaussianNoise = activated;
-    this->noisePower = power;
-    this->noiseStdDev = stddev;
+    QMutexLocker locker(&this->settings.mutex);
+    this->settings.config.addGaussianNoise = activated;
+    this->settings.config.noisePower = power;
+    this->settings.config.noiseStdDev = stddev;
+    this->settings.changed();
 }
 
 void ComputerVisionInterface::rgbToGray(bool active){
     this->setLoopLock(true);
-    this->convertToGray=active;
+    QMutexLocker locker(&this->settings.mutex);
+    this->settings.config.convertToGray = active;
+    this->settings.changed();
 }
 
 void ComputerVisionInterface::setUpdateHistogram(bool active){
@@ -776,87 +578,137 @@ void ComputerVisionInterface::setUpdateHistogram(bool active){
     this->updateHistogram=active;
 }
 
+// Only count this part of the processed frame (empty rect: whole frame)
+void ComputerVisionInterface::setHistogramRoi(const cv::Rect &roi){
+    this->histogram.setRoi(roi);
+}
+
+// Count every step-th row and column, for high resolution inputs
+void ComputerVisionInterface::setHistogramSubsample(int step){
+    this->histogram.setSubsample(step);
+}
+
+// Counts of one channel (B, G, R) of the last histogram computed
+std::vector<int> ComputerVisionInterface::getHistogramBins(int channel){
+    return this->histogram.getBins(channel);
+}
+
 void ComputerVisionInterface::setHistogramEqualization(bool active){
     this->setLoopLock(true);
-    this->equalizeHistogram = active;
+    QMutexLocker locker(&this->settings.mutex);
+    this->settings.config.equalizeHistogram = active;
+    this->settings.changed();
 }
 
 void ComputerVisionInterface::setRGBToHLS(bool act){
     this->setLoopLock(true);
-    this->rgbToHls=act;
+    QMutexLocker locker(&this->settings.mutex);
+    this->settings.config.rgbToHls = act;
+    this->settings.changed();
 }
 
 void ComputerVisionInterface::setRGBToXYZ(bool act){
     this->setLoopLock(true);
-    this->rgbToXyz=act;
+    QMutexLocker locker(&this->settings.mutex);
+    this->settings.config.rgbToXyz = act;
+    this->settings.changed();
 }
 
 void ComputerVisionInterface::setRGBToYCbCr(bool act){
     this->setLoopLock(true);
-    this->rgbToYcbcr=act;
+    QMutexLocker locker(&this->settings.mutex);
+    this->settings.config.rgbToYcbcr = act;
+    this->settings.changed();
 }
 
 void ComputerVisionInterface::setRGBToHSV(bool act){
     this->setLoopLock(true);
-    this->rgbToHsv=act;
+    QMutexLocker locker(&this->settings.mutex);
+    this->settings.config.rgbToHsv = act;
+    this->settings.changed();
 }
 
 void ComputerVisionInterface::setRGBToLAB(bool act){
     this->setLoopLock(true);
-    this->rgbToLab=act;
+    QMutexLocker locker(&this->settings.mutex);
+    this->settings.config.rgbToLab = act;
+    this->settings.changed();
 }
 
 void ComputerVisionInterface::setRGBToLUV(bool act){
     this->setLoopLock(true);
-    this->rgbToLuv=act;
+    QMutexLocker locker(&this->settings.mutex);
+    this->settings.config.rgbToLuv = act;
+    this->settings.changed();
 }
 
 void ComputerVisionInterface::setLogo(bool act, QString filename, double x, double y){
     this->setLoopLock(true);
-    this->xlogo=x;
-    this->ylogo=y;
-    this->logoActivated = act;
-    this->logoFilename = filename.toStdString();
+    // Decode here, once, instead of in the processing loop
+    cv::Mat logo;
+    if (act)
+        logo = cv::imread(filename.toStdString(), CV_LOAD_IMAGE_UNCHANGED);
+    QMutexLocker locker(&this->settings.mutex);
+    this->settings.config.xlogo = x;
+    this->settings.config.ylogo = y;
+    this->settings.config.logoActivated = act;
+    this->settings.config.logoFilename = filename.toStdString();
+    this->settings.config.logoImage = logo;
+    this->settings.changed();
 }
 
 void ComputerVisionInterface::setLogoPosition(double x, double y){
     this->setLoopLock(true);
-    this->xlogo=x;
-    this->ylogo=y;
+    QMutexLocker locker(&this->settings.mutex);
+    this->settings.config.xlogo = x;
+    this->settings.config.ylogo = y;
+    this->settings.changed();
 }
 
 void ComputerVisionInterface::setLogoTransparency(int v){
-    this->transparency = v;
+    QMutexLocker locker(&this->settings.mutex);
+    this->settings.config.transparency = v;
+    this->settings.changed();
 }
 
 void ComputerVisionInterface::applyStereoFun(QString type){
-    this->stereo = type;
+    this->stereo = parseStereoType(type);
 }
 
 void ComputerVisionInterface::applyMorpho(QString type, double param){
-    this->morpho = type;
-    this->morphoSize=param;
+    QMutexLocker locker(&this->settings.mutex);
+    this->settings.config.morpho = parseMorphoType(type);
+    this->settings.config.morphoSize = param;
+    this->settings.changed();
 }
 
 void ComputerVisionInterface::setMorphoSize(double param){
-    this->morphoSize=param;
+    QMutexLocker locker(&this->settings.mutex);
+    this->settings.config.morphoSize = param;
+    this->settings.changed();
 }
 
 void ComputerVisionInterface::applyFilter(QString type, double param){
-    this->filter = type;
-    this->filterParam = param;
+    QMutexLocker locker(&this->settings.mutex);
+    this->settings.config.filter = parseFilterType(type);
+    this->settings.config.filterParam = param;
+    this->settings.changed();
 }
 
 void ComputerVisionInterface::applyHough(QString type, double param){
-    this->hough = type;
-    this->houghParam=param;
+    QMutexLocker locker(&this->settings.mutex);
+    this->settings.config.hough = parseHoughType(type);
+    this->settings.config.houghParam = param;
+    this->settings.changed();
 }
 
 void ComputerVisionInterface::applyCanny(bool canny, double c1, double c2){
     this->setLoopLock(true);
-    this->canny = canny;
-    this->cannyParam1=c1;
-    this->cannyParam2=c2;
+    QMutexLocker locker(&this->settings.mutex);
+    this->settings.config.canny = canny;
+    this->settings.config.cannyParam1 = c1;
+    this->settings.config.cannyParam2 = c2;
+    this->settings.changed();
 }
 
 /** Auxiliar Functions **/
@@ -911,52 +763,6 @@ bool ComputerVisionInterface::getEndVideo(){
     return this->endVideo;
 }
 
-cv::Mat ComputerVisionInterface::drawHistogram(cv::Mat src){
-    /// Separate the image in 3 places ( B, G and R )
-    std::vector<cv::Mat> bgr_planes;
-    split( src, bgr_planes );
-    /// Establish the number of bins
-    int histSize = 256;
-    bool uniform = true; bool accumulate = false;
-
-
-    /// Set the ranges ( for B,G,R) )
-    float range[] = { -5, 260 } ;
-    const float* histRange = { range };
-
-    cv::Mat b_hist, g_hist, r_hist;
-
-    /// Compute the histograms:
-    calcHist( &bgr_planes[0], 1, 0, cv::Mat(), b_hist, 1, &histSize, &histRange, uniform, accumulate );
-    calcHist( &bgr_planes[1], 1, 0, cv::Mat(), g_hist, 1, &histSize, &histRange, uniform, accumulate );
-    calcHist( &bgr_planes[2], 1, 0, cv::Mat(), r_hist, 1, &histSize, &histRange, uniform, accumulate );
-
-    /// Draw the histograms for B, G and R
-    int hist_w = 512; int hist_h = 400;
-    int bin_w = cvRound( (double) hist_w/histSize );
-
-    cv::Mat histImage( hist_h, hist_w, CV_8UC3, cv::Scalar( 128,128,128 ) );
-
-    /// Normalize the result to [ 0, histImage.rows ]
-    cv::normalize(b_hist, b_hist, 0, histImage.rows, cv::NORM_MINMAX, -1, cv::Mat() );
-    cv::normalize(g_hist, g_hist, 0, histImage.rows, cv::NORM_MINMAX, -1, cv::Mat() );
-    cv::normalize(r_hist, r_hist, 0, histImage.rows, cv::NORM_MINMAX, -1, cv::Mat() );
-
-    /// Draw for each channel
-    for( int i = 1; i < histSize; i++ ){
-       line( histImage, cv::Point( bin_w*(i-1), hist_h - cvRound(b_hist.at<float>(i-1)) ) ,
-                        cv::Point( bin_w*(i), hist_h - cvRound(b_hist.at<float>(i)) ),
-                        cv::Scalar( 255, 0, 0), 4, 8, 0  );
-       line( histImage, cv::Point( bin_w*(i-1), hist_h - cvRound(g_hist.at<float>(i-1)) ) ,
-                        cv::Point( bin_w*(i), hist_h - cvRound(g_hist.at<float>(i)) ),
-                        cv::Scalar( 0, 255, 0), 4, 8, 0  );
-       line( histImage, cv::Point( bin_w*(i-1), hist_h - cvRound(r_hist.at<float>(i-1)) ) ,
-                        cv::Point( bin_w*(i), hist_h - cvRound(r_hist.at<float>(i)) ),
-                        cv::Scalar( 0, 0, 255), 4, 8, 0  );
-    }
-    return histImage;
-}
-
 void ComputerVisionInterface::setFrameFilename(QString filename){
     this->frameFilename = filename.toStdString();
 }
@@ -13,9 +13,20 @@
 #include <QObject>
 #include <QImage>
 #include <QString>
+#include <QMutex>
+#include <QAtomicInt>
 #include <string>
 #include "opencv2/opencv.hpp"
 #include "cameracalibrator.h"
+#include "matconverter.h"
+#include "framechannel.h"
+#include "pipelineconfig.h"
+#include "framesource.h"
+#include "streampipeline.h"
+#include "stageprofiler.h"
+#include "histogramengine.h"
+#include "detectorregistry.h"
+#include "robustmatcher.h"
 
 #define _ON_CAM    1
 #define _ON_FRAME  2
@@ -27,6 +38,13 @@ public:
     ComputerVisionInterface();
     ~ComputerVisionInterface();
     void setLoopLock(bool);
+    void setFrameChannel(FrameChannel *channel);
+    void setProcessingWorkers(int n);
+    void setDropFrames(bool drop);
+    StreamStats getStreamStats();
+    void setProfilerOverlay(bool active);
+    ProfileSummary getProfileSummary(ProfileBlock block);
+    void resetProfiler();
     void setWorkingOnCam(bool);
     void setWorkingOnFrame(bool);
     void setWorkingOnVideo(bool);
@@ -41,6 +59,9 @@ public:
     void setNoiseStdDev(int val/*min=0, max=99*/);
     void rgbToGray(bool active);
     void setUpdateHistogram(bool active);
+    void setHistogramRoi(const cv::Rect &roi);
+    void setHistogramSubsample(int step);
+    std::vector<int> getHistogramBins(int channel);
     void setHistogramEqualization(bool active);
     void setRGBToHSV(bool);
     void setRGBToLUV(bool);
@@ -61,6 +82,8 @@ public:
     void setMorphoSize(double sz);
     void applyHough(QString type, double param);
     void setHoughParams(double);
+    void setHoughTracking(bool active);
+    void setHoughCircleRange(int minRadius, int maxRadius, int pyramidLevel);
     void applyCanny(bool, double, double);
     void setCannyParams(double, double);
     void findConObjs(bool);
@@ -70,6 +93,7 @@ public:
     void findFeature(QString type);
     void setFeatureParam(double v);
     void computeFundamentalMatrix(QString);
+    void setStereoFeature(QString type);
     void selectView1(bool v=true);
     void selectView2(bool v=true);
     void applyStereoFun(QString type);
@@ -98,51 +122,25 @@ private:
     bool workingOnCam;
     bool workingOnFrame;
     bool workingOnVideo;
-    bool addSaltPepperNoise;
-    bool addGaussianNoise;
     bool updateHistogram;
-    bool equalizeHistogram;
-    int noisePower;
-    int noiseStdDev;
-    bool convertToGray;
-    bool rgbToHsv;
-    bool rgbToLab;
-    bool rgbToXyz;
-    bool rgbToYcbcr;
-    bool rgbToLuv;
-    bool rgbToHls;
-    bool logoActivated;
-    double xlogo;
-    double ylogo;
-    int transparency;
     bool endVideo;
-    QString fundamentalMethod;
-    QString filter;
-    QString morpho;
-    QString hough;
-    QString shape;
-    QString feature;
-    QString stereo;
+    int fundamentalMethod; /*CV_FM_* or -1 when nothing has to be computed*/
+    StereoType stereo;
     cv::Mat mview1;
     cv::Mat mview2;
     int showmview;
     std::vector<cv::KeyPoint> keypoints1, keypoints2;
     std::vector<cv::DMatch> matches;
+    DetectorRegistry detectors;
+    RobustMatcher matcher; /*configured once, only the F method changes per request*/
+    int stereoFeature;  /*DetectorKind asked by the GUI*/
+    int matcherFeature; /*DetectorKind the matcher is set up with*/
+    void configureMatcher(DetectorKind kind);
     cv::Mat F;
     cv::Mat H;
     cv::Mat E;
     bool bmview1;
     bool bmview2;
-    double featureParam;
-    int morphoSize;
-    double filterParam;
-    double houghParam;
-    bool canny;
-    double cannyParam1;
-    double cannyParam2;
-    bool conObjs;
-    bool contours;
-    double threshold;
     bool calibrate; //make calibration
     bool calibrated;//calibration state
     int numImagesCalibration;
@@ -155,16 +153,22 @@ private:
     QString stitchName;
     bool stitch;
     bool doSfm;
+    /* Processing chain: setters edit settings, the stream workers rebuild on change */
+    PipelineSettings settings;
+    FrameSource source;
+    StreamPipeline stream;
+    StageProfiler profiler;
     CameraCalibrator calibrator;
-    std::string logoFilename;
     std::string frameFilename;
     std::string videoFilename;
     cv::VideoCapture capture1;
     cv::VideoCapture capture2;
-    QImage Mat2QImage(IplImage *);
-    QImage Mat2QImage(cv::Mat &);
+    FrameChannel *frameChannel;
+    MatConverter originalConverter;
+    MatConverter processedConverter;
+    MatConverter histogramConverter;
     void computerVisionMachine(void);
-    cv::Mat drawHistogram(cv::Mat src);
+    HistogramEngine histogram;
     std::vector<cv::Mat> stitchImages;
     std::vector<cv::Mat> sfmImages;
     std::vector<std::string> imageIds;
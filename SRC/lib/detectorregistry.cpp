@@ -0,0 +1,85 @@
+/*
+    @file: detectorregistry.cpp
+    @license: GNU General Public License
+    @author: Juan Manuel Perez Rua
+    @note: Code written for th practical module of
+    Visual Perception at the Université de Bourgogne
+*/
+
+#include "detectorregistry.h"
+
+DetectorRegistry::DetectorRegistry(){
+    this->constructions=0;
+}
+
+/* Existing instance of kind, or a new one when param changed */
+DetectorRegistry::Entry &DetectorRegistry::entry(DetectorKind kind, double param){
+    std::map<int, Entry>::iterator it = this->entries.find(kind);
+    if (it!=this->entries.end() && it->second.param==param)
+        return it->second;
+
+    Entry &e = this->entries[kind];
+    e.param=param;
+    e.detector.release();
+    e.extractor.release();
+    switch (kind){
+    case DETECTOR_STAR:
+        e.detector = new cv::StarDetector(5, param, 5, 5, 10);
+        break;
+    case DETECTOR_SIFT:{
+        cv::Ptr<cv::SIFT> sift = new cv::SIFT(1, param, 0.04, 10, 1.6);
+        e.detector = sift;
+        e.extractor = sift;
+        break;
+    }
+    case DETECTOR_SURF:{
+        // The hessian threshold only affects detection, so one object serves both
+        cv::Ptr<cv::SURF> surf = new cv::SURF(param);
+        e.detector = surf;
+        e.extractor = surf;
+        break;
+    }
+    case DETECTOR_ORB:{
+        cv::Ptr<cv::ORB> orb = new cv::ORB(param);
+        e.detector = orb;
+        e.extractor = orb;
+        break;
+    }
+    case DETECTOR_BRISK:{
+        cv::Ptr<cv::BRISK> brisk = new cv::BRISK(param);
+        e.detector = brisk;
+        e.extractor = brisk;
+        break;
+    }
+    }
+    this->constructions++;
+    return e;
+}
+
+cv::Ptr<cv::FeatureDetector> DetectorRegistry::detector(DetectorKind kind, double param){
+    return entry(kind, param).detector;
+}
+
+// Empty for kinds without descriptors (STAR)
+cv::Ptr<cv::DescriptorExtractor> DetectorRegistry::extractor(DetectorKind kind, double param){
+    return entry(kind, param).extractor;
+}
+
+// MSER through its region interface (the contours the MSER stage draws)
+cv::Ptr<cv::MSER> DetectorRegistry::mser(){
+    if (this->mserDet.empty()){
+        this->mserDet = new cv::MSER();
+        this->constructions++;
+    }
+    return this->mserDet;
+}
+
+void DetectorRegistry::clear(){
+    this->entries.clear();
+    this->mserDet.release();
+}
+
+// Detector objects built so far; stays put while only other settings change
+int DetectorRegistry::getConstructions() const{
+    return this->constructions;
+}
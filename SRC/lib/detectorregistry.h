@@ -0,0 +1,49 @@
+/*
+    @file: detectorregistry.h
+    @license: GNU General Public License
+    @author: Juan Manuel Perez Rua
+    @note: Code written for th practical module of
+    Visual Perception at the Université de Bourgogne
+*/
+
+#ifndef DETECTORREGISTRY_H
+#define DETECTORREGISTRY_H
+
+#include <map>
+#include "opencv2/opencv.hpp"
+#include "opencv2/nonfree/features2d.hpp"
+
+enum DetectorKind{
+    DETECTOR_STAR,  // param: response threshold
+    DETECTOR_SIFT,  // param: octave layers
+    DETECTOR_SURF,  // param: hessian threshold
+    DETECTOR_ORB,   // param: number of features; binary descriptors
+    DETECTOR_BRISK  // param: FAST threshold; binary descriptors
+};
+
+// Long-lived feature detector/extractor instances, one per kind. An
+// instance is constructed the first time its kind is asked for and then
+// handed out again, so its internal buffers survive pipeline rebuilds; it
+// is only replaced when the parameter of its kind changes. Not thread
+// safe: every owner (pipeline worker, GUI loop) keeps its own registry.
+class DetectorRegistry{
+public:
+    DetectorRegistry();
+    cv::Ptr<cv::FeatureDetector> detector(DetectorKind kind, double param=0);
+    cv::Ptr<cv::DescriptorExtractor> extractor(DetectorKind kind, double param=0);
+    cv::Ptr<cv::MSER> mser();
+    void clear();
+    int getConstructions() const;
+private:
+    struct Entry{
+        double param;
+        cv::Ptr<cv::FeatureDetector> detector;
+        cv::Ptr<cv::DescriptorExtractor> extractor; // empty for detect-only kinds
+    };
+    Entry &entry(DetectorKind kind, double param);
+    std::map<int, Entry> entries;
+    cv::Ptr<cv::MSER> mserDet;
+    int constructions;
+};
+
+#endif // DETECTORREGISTRY_H
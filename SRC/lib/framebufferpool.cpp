@@ -0,0 +1,60 @@
+/*
+    @file: framebufferpool.cpp
+    @license: GNU General Public License
+    @author: Juan Manuel Perez Rua
+    @note: Code written for th practical module of
+    Visual Perception at the Université de Bourgogne
+*/
+
+#include "framebufferpool.h"
+
+bool FrameBufferPool::Key::operator<(const Key &o) const{
+    if (this->rows!=o.rows) return this->rows<o.rows;
+    if (this->cols!=o.cols) return this->cols<o.cols;
+    return this->type<o.type;
+}
+
+FrameBufferPool::FrameBufferPool(int maxPerSize){
+    this->maxPerSize = maxPerSize>0 ? maxPerSize : 1;
+}
+
+// The returned buffer is uninitialized
+cv::Mat FrameBufferPool::acquire(int rows, int cols, int type){
+    QMutexLocker locker(&this->mutex);
+    std::vector<cv::Mat> &list = this->buffers[Key(rows, cols, type)];
+    for (unsigned int i=0; i<list.size(); i++){
+        // Only the pool holds it: free to hand out again
+        if (list[i].refcount!=NULL && *list[i].refcount==1)
+            return list[i];
+    }
+    this->allocations.ref();
+    cv::Mat buffer(rows, cols, type);
+    // Past the limit the buffer is not tracked (and will simply be freed)
+    if ((int)list.size()<this->maxPerSize)
+        list.push_back(buffer);
+    return buffer;
+}
+
+cv::Mat FrameBufferPool::acquire(const cv::Size &size, int type){
+    return acquire(size.height, size.width, type);
+}
+
+// Buffers allocated since construction, should stop growing after warm-up
+int FrameBufferPool::getAllocations(){
+    return this->allocations;
+}
+
+int FrameBufferPool::getBuffers(){
+    QMutexLocker locker(&this->mutex);
+    int n=0;
+    std::map< Key, std::vector<cv::Mat> >::const_iterator it;
+    for (it=this->buffers.begin(); it!=this->buffers.end(); ++it)
+        n += it->second.size();
+    return n;
+}
+
+// Forget every buffer (those still in use stay alive with their users)
+void FrameBufferPool::clear(){
+    QMutexLocker locker(&this->mutex);
+    this->buffers.clear();
+}
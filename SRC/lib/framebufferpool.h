@@ -0,0 +1,43 @@
+/*
+    @file: framebufferpool.h
+    @license: GNU General Public License
+    @author: Juan Manuel Perez Rua
+    @note: Code written for th practical module of
+    Visual Perception at the Université de Bourgogne
+*/
+
+#ifndef FRAMEBUFFERPOOL_H
+#define FRAMEBUFFERPOOL_H
+
+#include <map>
+#include <vector>
+#include <QMutex>
+#include <QAtomicInt>
+#include "opencv2/opencv.hpp"
+
+// cv::Mat buffers keyed by (rows, cols, type). acquire() hands out a buffer
+// that nobody else references; the caller gives it back simply by dropping
+// its cv::Mat (the pool sees the reference count fall back to one). After
+// the first frames at a given resolution every acquire() is served from
+// the pool, so the steady state allocates nothing. Thread safe.
+class FrameBufferPool{
+public:
+    FrameBufferPool(int maxPerSize=8);
+    cv::Mat acquire(int rows, int cols, int type);
+    cv::Mat acquire(const cv::Size &size, int type);
+    int getAllocations();
+    int getBuffers();
+    void clear();
+private:
+    struct Key{
+        Key(int rows, int cols, int type) : rows(rows), cols(cols), type(type){}
+        bool operator<(const Key &o) const;
+        int rows, cols, type;
+    };
+    std::map< Key, std::vector<cv::Mat> > buffers;
+    int maxPerSize;
+    QAtomicInt allocations;
+    QMutex mutex;
+};
+
+#endif // FRAMEBUFFERPOOL_H
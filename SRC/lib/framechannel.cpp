@@ -0,0 +1,58 @@
+/*
+    @file: framechannel.cpp
+    @license: GNU General Public License
+    @author: Juan Manuel Perez Rua
+    @note: Code written for th practical module of
+    Visual Perception at the Université de Bourgogne
+*/
+
+#include "framechannel.h"
+#include <QMutexLocker>
+
+FrameChannel::FrameChannel(QObject *parent) :
+    QObject(parent){
+    this->sequence=0;
+    this->dropped=0;
+}
+
+// Called from the vision thread once per processed frame
+void FrameChannel::publish(const QImage &original, const QImage &processed, const QImage &histogram){
+    VisionFrame *frame = new VisionFrame;
+    frame->original = original;
+    frame->processed = processed;
+    frame->histogram = histogram;
+
+    {
+        QMutexLocker locker(&this->mutex);
+        frame->sequence = ++this->sequence;
+        this->current = VisionFramePtr(frame);
+        // The GUI has not taken the previous frame: it is simply replaced
+        if (this->pending.fetchAndStoreOrdered(1)!=0){
+            this->dropped++;
+            return;
+        }
+    }
+    emit frameReady();
+}
+
+// Called from the GUI thread when frameReady() arrives
+VisionFramePtr FrameChannel::take(){
+    QMutexLocker locker(&this->mutex);
+    this->pending.fetchAndStoreOrdered(0);
+    return this->current;
+}
+
+VisionFramePtr FrameChannel::latest(){
+    QMutexLocker locker(&this->mutex);
+    return this->current;
+}
+
+quint64 FrameChannel::getPublished(){
+    QMutexLocker locker(&this->mutex);
+    return this->sequence;
+}
+
+quint64 FrameChannel::getDropped(){
+    QMutexLocker locker(&this->mutex);
+    return this->dropped;
+}
@@ -0,0 +1,53 @@
+/*
+    @file: framechannel.h
+    @license: GNU General Public License
+    @author: Juan Manuel Perez Rua
+    @note: Code written for th practical module of
+    Visual Perception at the Université de Bourgogne
+*/
+
+#ifndef FRAMECHANNEL_H
+#define FRAMECHANNEL_H
+
+#include <QObject>
+#include <QImage>
+#include <QMutex>
+#include <QAtomicInt>
+#include <QSharedPointer>
+
+// One published result of the vision loop. It is never modified after
+// publish(), so the GUI can keep and paint it while the worker goes on.
+struct VisionFrame{
+    quint64 sequence;
+    QImage original;
+    QImage processed;
+    QImage histogram;
+};
+
+typedef QSharedPointer<const VisionFrame> VisionFramePtr;
+
+// Hands frames from the vision thread to the GUI. Only the newest frame is
+// kept: if the GUI has not picked up the previous one yet it is replaced
+// (counted as dropped) and no extra frameReady() is queued.
+class FrameChannel : public QObject{
+    Q_OBJECT
+public:
+    explicit FrameChannel(QObject *parent = 0);
+    void publish(const QImage &original, const QImage &processed, const QImage &histogram);
+    VisionFramePtr take();
+    VisionFramePtr latest();
+    quint64 getPublished();
+    quint64 getDropped();
+
+signals:
+    void frameReady();
+
+private:
+    QMutex mutex;
+    QAtomicInt pending;
+    VisionFramePtr current;
+    quint64 sequence;
+    quint64 dropped;
+};
+
+#endif // FRAMECHANNEL_H
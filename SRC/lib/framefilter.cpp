@@ -0,0 +1,116 @@
+/*
+    @file: framefilter.cpp
+    @license: GNU General Public License
+    @author: Juan Manuel Perez Rua
+    @note: Code written for th practical module of
+    Visual Perception at the Université de Bourgogne
+*/
+
+#include "framefilter.h"
+#include <algorithm>
+#if CV_SSE2
+#include <emmintrin.h>
+#endif
+
+/* blurred = saturate(1.5*source - 0.5*blurred), (3s-b)/2 rounded half to even like cvRound */
+static void unsharpRow(const uchar *source, uchar *blurred, int n){
+    int i=0;
+#if CV_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi16(1);
+    for (; i<=n-16; i+=16){
+        __m128i s = _mm_loadu_si128((const __m128i*)(source+i));
+        __m128i b = _mm_loadu_si128((const __m128i*)(blurred+i));
+        __m128i s0 = _mm_unpacklo_epi8(s, zero), s1 = _mm_unpackhi_epi8(s, zero);
+        __m128i v0 = _mm_sub_epi16(_mm_add_epi16(s0, _mm_add_epi16(s0, s0)), _mm_unpacklo_epi8(b, zero));
+        __m128i v1 = _mm_sub_epi16(_mm_add_epi16(s1, _mm_add_epi16(s1, s1)), _mm_unpackhi_epi8(b, zero));
+        __m128i q0 = _mm_srai_epi16(v0, 1), q1 = _mm_srai_epi16(v1, 1);
+        q0 = _mm_add_epi16(q0, _mm_and_si128(_mm_and_si128(v0, q0), one));
+        q1 = _mm_add_epi16(q1, _mm_and_si128(_mm_and_si128(v1, q1), one));
+        _mm_storeu_si128((__m128i*)(blurred+i), _mm_packus_epi16(q0, q1));
+    }
+#endif
+    for (; i<n; i++){
+        int v = 3*source[i] - blurred[i];
+        int q = v>>1;
+        q += v & q & 1;
+        blurred[i] = (uchar)(q<0 ? 0 : (q>255 ? 255 : q));
+    }
+}
+
+class FilterBody : public cv::ParallelLoopBody{
+public:
+    FilterBody(const FrameFilter &filter, const cv::Mat &src, cv::Mat &dst, int stripeRows)
+        : filter(filter), src(src), dst(dst), stripeRows(stripeRows){}
+    void operator()(const cv::Range &stripes) const{
+        for (int s=stripes.start; s<stripes.end; s++)
+            this->filter.applyRows(this->src, this->dst, s*this->stripeRows,
+                                   std::min(this->src.rows, (s+1)*this->stripeRows));
+    }
+private:
+    const FrameFilter &filter;
+    const cv::Mat &src;
+    cv::Mat &dst;
+    int stripeRows;
+};
+
+FrameFilter::FrameFilter(){
+    this->kind=FILTER_COPY;
+    this->ksize=1;
+    this->sigma=0;
+}
+
+// Normalized ksize x ksize box, same as cv::blur
+void FrameFilter::setBox(int ksize){
+    this->kind = ksize>1 ? FILTER_BOX : FILTER_COPY;
+    this->ksize=ksize;
+}
+
+// Unsharp mask over a ksize x ksize Gaussian (ksize odd)
+void FrameFilter::setUnsharp(int ksize, double sigma){
+    this->kind = ksize>1 ? FILTER_UNSHARP : FILTER_COPY;
+    this->ksize=ksize;
+    this->sigma=sigma;
+}
+
+FrameFilter::Kind FrameFilter::getKind() const{
+    return this->kind;
+}
+
+void FrameFilter::apply(const cv::Mat &src, cv::Mat &dst) const{
+    CV_Assert(src.data!=dst.data || src.empty());
+    dst.create(src.size(), src.type());
+    if (this->kind==FILTER_COPY || src.empty()){
+        src.copyTo(dst);
+        return;
+    }
+    int stripes = std::min(cv::getNumThreads(), src.rows/(4*this->ksize));
+    if (stripes<=1){
+        applyRows(src, dst, 0, src.rows);
+        return;
+    }
+    int stripeRows = (src.rows+stripes-1)/stripes;
+    cv::parallel_for_(cv::Range(0, stripes), FilterBody(*this, src, dst, stripeRows));
+}
+
+// Filter rows [start,end) of src into the same rows of dst
+void FrameFilter::applyRows(const cv::Mat &src, cv::Mat &dst, int start, int end) const{
+    const cv::Mat in = src.rowRange(start, end);
+    cv::Mat out = dst.rowRange(start, end);
+    switch (this->kind){
+    case FILTER_BOX:
+        cv::blur(in, out, cv::Size(this->ksize, this->ksize));
+        break;
+    case FILTER_UNSHARP:
+        cv::GaussianBlur(in, out, cv::Size(this->ksize, this->ksize), this->sigma);
+        if (in.depth()==CV_8U){
+            int n = in.cols*in.channels();
+            for (int r=0; r<in.rows; r++)
+                unsharpRow(in.ptr<uchar>(r), out.ptr<uchar>(r), n);
+        }else
+            cv::addWeighted(in, 1.5, out, -0.5, 0, out);
+        break;
+    default:
+        in.copyTo(out);
+    }
+}
@@ -0,0 +1,39 @@
+/*
+    @file: framefilter.h
+    @license: GNU General Public License
+    @author: Juan Manuel Perez Rua
+    @note: Code written for th practical module of
+    Visual Perception at the Université de Bourgogne
+*/
+
+#ifndef FRAMEFILTER_H
+#define FRAMEFILTER_H
+
+#include "opencv2/opencv.hpp"
+
+// Smoothing filters of the BLUR/SHARP stages, run on horizontal stripes of
+// the frame in parallel. Each stripe is a ROI of the whole source, so the
+// OpenCV filters read the rows around it instead of extrapolating a border
+// and the result is the same as filtering the frame in one go. Stripes are
+// kept several kernels tall so the halo rows are not filtered too often.
+//  - BOX: running sums (OpenCV's box filter), O(1) per pixel whatever the size
+//  - UNSHARP: separable Gaussian with the kernel cached by OpenCV, then
+//    1.5*source - 0.5*blurred on the same rows while they are still in
+//    cache (integer arithmetic, rounding like addWeighted)
+// source and destination must not share data.
+class FrameFilter{
+public:
+    enum Kind{ FILTER_COPY, FILTER_BOX, FILTER_UNSHARP };
+    FrameFilter();
+    void setBox(int ksize);
+    void setUnsharp(int ksize, double sigma);
+    void apply(const cv::Mat &src, cv::Mat &dst) const;
+    void applyRows(const cv::Mat &src, cv::Mat &dst, int start, int end) const;
+    Kind getKind() const;
+private:
+    Kind kind;
+    int ksize;
+    double sigma;
+};
+
+#endif // FRAMEFILTER_H
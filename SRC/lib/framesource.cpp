@@ -0,0 +1,106 @@
+/*
+    @file: framesource.cpp
+    @license: GNU General Public License
+    @author: Juan Manuel Perez Rua
+    @note: Code written for th practical module of
+    Visual Perception at the Université de Bourgogne
+*/
+
+#include "framesource.h"
+#include <cstdio>
+#include <iostream>
+
+FrameSource::FrameSource(){
+    this->mode=SOURCE_NONE;
+    this->next=0;
+}
+
+bool FrameSource::openCamera(int device){
+    close();
+    if (!this->capture.open(device))
+        return false;
+    this->mode=SOURCE_CAMERA;
+    return true;
+}
+
+bool FrameSource::openVideo(const std::string &filename){
+    close();
+    if (!this->capture.open(filename))
+        return false;
+    this->mode=SOURCE_VIDEO;
+    return true;
+}
+
+bool FrameSource::openImage(const std::string &filename){
+    close();
+    this->filename=filename;
+    this->mode=SOURCE_IMAGE;
+    return true;
+}
+
+bool FrameSource::openSequence(const std::vector<std::string> &filenames){
+    close();
+    if (filenames.empty())
+        return false;
+    this->sequence=filenames;
+    this->next=0;
+    this->mode=SOURCE_SEQUENCE;
+    return true;
+}
+
+void FrameSource::close(){
+    if (this->capture.isOpened())
+        this->capture.release();
+    this->mode=SOURCE_NONE;
+}
+
+// Returns false when the source is exhausted (end of video, camera lost, bad file)
+bool FrameSource::read(cv::Mat &frame){
+    switch (this->mode){
+    case SOURCE_CAMERA:
+    case SOURCE_VIDEO:
+        return this->capture.grab() && this->capture.retrieve(frame) && !frame.empty();
+    case SOURCE_IMAGE:
+        frame = cv::imread(this->filename, CV_LOAD_IMAGE_COLOR);
+        return !frame.empty();
+    case SOURCE_SEQUENCE:
+        // An unreadable file still takes its place in the sequence (as an
+        // empty frame) so sequence numbers keep matching file names
+        if (this->next>=this->sequence.size())
+            return false;
+        frame = cv::imread(this->sequence[this->next], CV_LOAD_IMAGE_COLOR);
+        if (frame.empty())
+            std::cerr<<"Cannot read "<<this->sequence[this->next]<<std::endl;
+        this->next++;
+        return true;
+    default:
+        return false;
+    }
+}
+
+FrameSource::Mode FrameSource::getMode() const{
+    return this->mode;
+}
+
+// Name to save the output of a frame under: the file base name for
+// sequences, frame_<n> otherwise. sequence starts at 1 (see StreamPipeline).
+std::string FrameSource::getFrameName(quint64 sequence) const{
+    if (this->mode==SOURCE_SEQUENCE && sequence>=1 && sequence<=this->sequence.size()){
+        std::string name = this->sequence[sequence-1];
+        size_t slash = name.find_last_of("/\\");
+        if (slash!=std::string::npos)
+            name = name.substr(slash+1);
+        size_t dot = name.find_last_of('.');
+        if (dot!=std::string::npos && dot>0)
+            name = name.substr(0, dot);
+        return name;
+    }
+    char name[32];
+    sprintf(name, "frame_%06d", (int)sequence);
+    return name;
+}
+
+// Milliseconds to wait between two reads (still images are polled at 10 Hz)
+int FrameSource::getFrameInterval() const{
+    return this->mode==SOURCE_IMAGE ? 100 : 0;
+}
@@ -0,0 +1,41 @@
+/*
+    @file: framesource.h
+    @license: GNU General Public License
+    @author: Juan Manuel Perez Rua
+    @note: Code written for th practical module of
+    Visual Perception at the Université de Bourgogne
+*/
+
+#ifndef FRAMESOURCE_H
+#define FRAMESOURCE_H
+
+#include <string>
+#include <vector>
+#include <QtGlobal>
+#include "opencv2/opencv.hpp"
+
+// Where the frames of a stream come from: a camera, a video file, a still
+// image that is re-read periodically (so edits on disk show up) or a list
+// of image files read once each (batch processing).
+class FrameSource{
+public:
+    enum Mode{ SOURCE_NONE, SOURCE_CAMERA, SOURCE_VIDEO, SOURCE_IMAGE, SOURCE_SEQUENCE };
+    FrameSource();
+    bool openCamera(int device=CV_CAP_ANY);
+    bool openVideo(const std::string &filename);
+    bool openImage(const std::string &filename);
+    bool openSequence(const std::vector<std::string> &filenames);
+    void close();
+    bool read(cv::Mat &frame);
+    Mode getMode() const;
+    int getFrameInterval() const;
+    std::string getFrameName(quint64 sequence) const;
+private:
+    Mode mode;
+    std::string filename;
+    std::vector<std::string> sequence;
+    unsigned int next;
+    cv::VideoCapture capture;
+};
+
+#endif // FRAMESOURCE_H
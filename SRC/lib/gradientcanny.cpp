@@ -0,0 +1,92 @@
+/*
+    @file: gradientcanny.cpp
+    @license: GNU General Public License
+    @author: Juan Manuel Perez Rua
+    @note: Code written for th practical module of
+    Visual Perception at the Université de Bourgogne
+*/
+
+#include "gradientcanny.h"
+#include <algorithm>
+#include <cstdlib>
+
+// tan(22.5 degrees) in fixed point, as in cv::Canny
+enum{ CANNY_SHIFT=15, TG22=(int)(0.4142135623730950488016887242097*(1<<CANNY_SHIFT)+0.5) };
+
+void GradientCanny::apply(const cv::Mat &dx, const cv::Mat &dy, double low, double high, cv::Mat &edges){
+    CV_Assert(dx.type()==CV_16S && dy.type()==CV_16S && dx.size()==dy.size());
+    if (low>high)
+        std::swap(low, high);
+    int lowT = cvFloor(low), highT = cvFloor(high);
+    int rows = dx.rows, cols = dx.cols;
+
+    /* L1 magnitude, surrounded by zeros */
+    this->magnitude.create(rows+2, cols+2, CV_32S);
+    this->magnitude.row(0).setTo(0);
+    this->magnitude.row(rows+1).setTo(0);
+    for (int y=0; y<rows; y++){
+        const short *gx = dx.ptr<short>(y), *gy = dy.ptr<short>(y);
+        int *m = this->magnitude.ptr<int>(y+1);
+        m[0] = m[cols+1] = 0;
+        for (int x=0; x<cols; x++)
+            m[x+1] = std::abs(gx[x]) + std::abs(gy[x]);
+    }
+
+    /* Local maxima across the gradient: over high are edges, over low candidates */
+    this->map.create(rows+2, cols+2, CV_8U);
+    this->map.row(0).setTo(1);
+    this->map.row(rows+1).setTo(1);
+    this->stack.clear();
+    int step = (int)this->map.step;
+    for (int y=0; y<rows; y++){
+        const short *gx = dx.ptr<short>(y), *gy = dy.ptr<short>(y);
+        const int *m = this->magnitude.ptr<int>(y+1)+1;
+        const int *previous = this->magnitude.ptr<int>(y)+1, *next = this->magnitude.ptr<int>(y+2)+1;
+        uchar *flags = this->map.ptr<uchar>(y+1);
+        flags[0] = flags[cols+1] = 1;
+        flags++;
+        for (int x=0; x<cols; x++){
+            int v = m[x];
+            bool maximum=false;
+            if (v>lowT){
+                int xs = gx[x], ys = gy[x];
+                int tg22x = std::abs(xs)*TG22, yy = std::abs(ys)<<CANNY_SHIFT;
+                if (yy<tg22x)
+                    maximum = v>m[x-1] && v>=m[x+1];
+                else if (yy>tg22x+(std::abs(xs)<<(CANNY_SHIFT+1)))
+                    maximum = v>previous[x] && v>=next[x];
+                else{
+                    int s = (xs^ys)<0 ? -1 : 1;
+                    maximum = v>previous[x-s] && v>next[x+s];
+                }
+            }
+            if (!maximum)
+                flags[x]=1;
+            else if (v>highT){
+                flags[x]=2;
+                this->stack.push_back(flags+x);
+            }else
+                flags[x]=0;
+        }
+    }
+
+    /* Hysteresis: candidates touching an edge become edges */
+    const int offsets[8] = { -step-1, -step, -step+1, -1, 1, step-1, step, step+1 };
+    while (!this->stack.empty()){
+        uchar *p = this->stack.back();
+        this->stack.pop_back();
+        for (int k=0; k<8; k++)
+            if (p[offsets[k]]==0){
+                p[offsets[k]]=2;
+                this->stack.push_back(p+offsets[k]);
+            }
+    }
+
+    edges.create(rows, cols, CV_8U);
+    for (int y=0; y<rows; y++){
+        const uchar *flags = this->map.ptr<uchar>(y+1)+1;
+        uchar *e = edges.ptr<uchar>(y);
+        for (int x=0; x<cols; x++)
+            e[x] = flags[x]==2 ? 255 : 0;
+    }
+}
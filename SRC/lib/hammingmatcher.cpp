@@ -0,0 +1,116 @@
+/*
+    @file: hammingmatcher.cpp
+    @license: GNU General Public License
+    @author: Juan Manuel Perez Rua
+    @note: Code written for th practical module of
+    Visual Perception at the Université de Bourgogne
+*/
+
+#include "hammingmatcher.h"
+#include <algorithm>
+#if CV_SSE2
+#include <emmintrin.h>
+#endif
+
+HammingMatcher::HammingMatcher(){
+}
+
+bool HammingMatcher::isMaskSupported() const{
+    return false;
+}
+
+cv::Ptr<cv::DescriptorMatcher> HammingMatcher::clone(bool emptyTrainData) const{
+    HammingMatcher *matcher = new HammingMatcher();
+    if (!emptyTrainData){
+        matcher->trainDescCollection.resize(this->trainDescCollection.size());
+        for (unsigned int i=0; i<this->trainDescCollection.size(); i++)
+            matcher->trainDescCollection[i] = this->trainDescCollection[i].clone();
+    }
+    return matcher;
+}
+
+/* Number of differing bits between two rows of bytes */
+int HammingMatcher::distance(const uchar *a, const uchar *b, int bytes){
+    int i=0, count=0;
+#if CV_SSE2
+    const __m128i m1 = _mm_set1_epi8(0x55);
+    const __m128i m2 = _mm_set1_epi8(0x33);
+    const __m128i m4 = _mm_set1_epi8(0x0f);
+    const __m128i zero = _mm_setzero_si128();
+    __m128i sum = zero;
+    for (; i<=bytes-16; i+=16){
+        __m128i v = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(a+i)), _mm_loadu_si128((const __m128i*)(b+i)));
+        // Bit counts per byte; the masks drop what the 16 bit shifts carry over
+        v = _mm_sub_epi8(v, _mm_and_si128(_mm_srli_epi16(v, 1), m1));
+        v = _mm_add_epi8(_mm_and_si128(v, m2), _mm_and_si128(_mm_srli_epi16(v, 2), m2));
+        v = _mm_and_si128(_mm_add_epi8(v, _mm_srli_epi16(v, 4)), m4);
+        sum = _mm_add_epi64(sum, _mm_sad_epu8(v, zero));
+    }
+    count = _mm_cvtsi128_si32(sum) + _mm_cvtsi128_si32(_mm_unpackhi_epi64(sum, sum));
+#endif
+    for (; i<bytes; i++){
+        uchar v = a[i]^b[i];
+        v = v - ((v>>1) & 0x55);
+        v = (v & 0x33) + ((v>>2) & 0x33);
+        count += (v + (v>>4)) & 0x0f;
+    }
+    return count;
+}
+
+void HammingMatcher::knnMatchImpl(const cv::Mat &queryDescriptors, std::vector< std::vector<cv::DMatch> > &matches, int k,
+                                  const std::vector<cv::Mat> &, bool compactResult){
+    CV_Assert(queryDescriptors.depth()==CV_8U);
+    matches.resize(queryDescriptors.rows);
+    std::vector<cv::DMatch> best;
+    for (int q=0; q<queryDescriptors.rows; q++){
+        const uchar *query = queryDescriptors.ptr<uchar>(q);
+        best.clear();
+        for (unsigned int img=0; img<this->trainDescCollection.size(); img++){
+            const cv::Mat &train = this->trainDescCollection[img];
+            CV_Assert(train.depth()==CV_8U && train.cols==queryDescriptors.cols);
+            for (int t=0; t<train.rows; t++){
+                int d = distance(query, train.ptr<uchar>(t), train.cols);
+                if ((int)best.size()==k && d>=best[k-1].distance)
+                    continue;
+                // Insert keeping the list sorted, earlier rows first on ties
+                int pos = best.size();
+                while (pos>0 && d<best[pos-1].distance)
+                    pos--;
+                best.insert(best.begin()+pos, cv::DMatch(q, t, img, (float)d));
+                if ((int)best.size()>k)
+                    best.pop_back();
+            }
+        }
+        matches[q] = best;
+    }
+    if (compactResult){
+        std::vector< std::vector<cv::DMatch> >::iterator it = matches.begin();
+        while (it!=matches.end())
+            it = it->empty() ? matches.erase(it) : it+1;
+    }
+}
+
+void HammingMatcher::radiusMatchImpl(const cv::Mat &queryDescriptors, std::vector< std::vector<cv::DMatch> > &matches, float maxDistance,
+                                     const std::vector<cv::Mat> &, bool compactResult){
+    CV_Assert(queryDescriptors.depth()==CV_8U);
+    matches.resize(queryDescriptors.rows);
+    for (int q=0; q<queryDescriptors.rows; q++){
+        const uchar *query = queryDescriptors.ptr<uchar>(q);
+        matches[q].clear();
+        for (unsigned int img=0; img<this->trainDescCollection.size(); img++){
+            const cv::Mat &train = this->trainDescCollection[img];
+            CV_Assert(train.depth()==CV_8U && train.cols==queryDescriptors.cols);
+            for (int t=0; t<train.rows; t++){
+                int d = distance(query, train.ptr<uchar>(t), train.cols);
+                if (d<maxDistance)
+                    matches[q].push_back(cv::DMatch(q, t, img, (float)d));
+            }
+        }
+        std::sort(matches[q].begin(), matches[q].end());
+    }
+    if (compactResult){
+        std::vector< std::vector<cv::DMatch> >::iterator it = matches.begin();
+        while (it!=matches.end())
+            it = it->empty() ? matches.erase(it) : it+1;
+    }
+}
@@ -0,0 +1,33 @@
+/*
+    @file: hammingmatcher.h
+    @license: GNU General Public License
+    @author: Juan Manuel Perez Rua
+    @note: Code written for th practical module of
+    Visual Perception at the Université de Bourgogne
+*/
+
+#ifndef HAMMINGMATCHER_H
+#define HAMMINGMATCHER_H
+
+#include <vector>
+#include "opencv2/opencv.hpp"
+
+// Brute force matcher for binary descriptors (ORB, BRISK, rows of CV_8U).
+// Distances are popcounts of the xor of two rows, 16 bytes at a time with
+// SSE2; the k best train rows of every query are kept with an insertion
+// into a k-long list, ties going to the lower train index like BFMatcher.
+// Masks are not supported.
+class HammingMatcher : public cv::DescriptorMatcher{
+public:
+    HammingMatcher();
+    bool isMaskSupported() const;
+    cv::Ptr<cv::DescriptorMatcher> clone(bool emptyTrainData=false) const;
+    static int distance(const uchar *a, const uchar *b, int bytes);
+protected:
+    void knnMatchImpl(const cv::Mat &queryDescriptors, std::vector< std::vector<cv::DMatch> > &matches, int k,
+                      const std::vector<cv::Mat> &masks=std::vector<cv::Mat>(), bool compactResult=false);
+    void radiusMatchImpl(const cv::Mat &queryDescriptors, std::vector< std::vector<cv::DMatch> > &matches, float maxDistance,
+                         const std::vector<cv::Mat> &masks=std::vector<cv::Mat>(), bool compactResult=false);
+};
+
+#endif // HAMMINGMATCHER_H
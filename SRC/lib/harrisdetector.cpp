@@ -0,0 +1,125 @@
+/*
+    @file: harrisdetector.cpp
+    @license: GNU General Public License
+    @author: Juan Manuel Perez Rua
+    @note: Code written for th practical module of
+    Visual Perception at the Université de Bourgogne
+*/
+
+#include "harrisdetector.h"
+#include <algorithm>
+#include <cfloat>
+
+class HarrisNmsBody : public cv::ParallelLoopBody{
+public:
+    HarrisNmsBody(HarrisDetector *detector, int stripes, float minimum)
+        : detector(detector), stripes(stripes), minimum(minimum){}
+    void operator()(const cv::Range &range) const{
+        for (int s=range.start; s<range.end; s++)
+            this->detector->suppress(s, this->stripes, this->minimum);
+    }
+private:
+    HarrisDetector *detector;
+    int stripes;
+    float minimum;
+};
+
+HarrisDetector::HarrisDetector(){
+    this->blockSize=3;
+    this->k=0.04;
+    this->threshold=128;
+}
+
+void HarrisDetector::setBlockSize(int blockSize){
+    this->blockSize = std::max(1, blockSize);
+}
+
+void HarrisDetector::setK(double k){
+    this->k=k;
+}
+
+// On the response normalized to 0..255
+void HarrisDetector::setThreshold(int threshold){
+    this->threshold=threshold;
+}
+
+/* Local maxima over minimum in the rows of one stripe (frame border excluded) */
+void HarrisDetector::suppress(int stripe, int stripes, float minimum){
+    std::vector<cv::Point> &out = this->stripeCorners[stripe];
+    out.clear();
+    int rows = this->response.rows-2, cols = this->response.cols;
+    int start = 1 + stripe*rows/stripes, end = 1 + (stripe+1)*rows/stripes;
+    for (int y=start; y<end; y++){
+        const float *above = this->response.ptr<float>(y-1);
+        const float *row = this->response.ptr<float>(y);
+        const float *below = this->response.ptr<float>(y+1);
+        for (int x=1; x<cols-1; x++){
+            float v = row[x];
+            // Ties go to the first pixel in raster order
+            if (v<minimum || v<=above[x-1] || v<=above[x] || v<=above[x+1] || v<=row[x-1]
+                    || v<row[x+1] || v<below[x-1] || v<below[x] || v<below[x+1])
+                continue;
+            out.push_back(cv::Point(x, y));
+        }
+    }
+}
+
+// Corners from the CV_16S Sobel derivatives of the image
+const std::vector<cv::Point> &HarrisDetector::detect(const cv::Mat &dx, const cv::Mat &dy){
+    CV_Assert(dx.type()==CV_16S && dy.type()==CV_16S && dx.size()==dy.size());
+    this->corners.clear();
+    this->tensor.create(dx.size(), CV_32FC3);
+    for (int y=0; y<dx.rows; y++){
+        const short *gx = dx.ptr<short>(y), *gy = dy.ptr<short>(y);
+        float *t = this->tensor.ptr<float>(y);
+        for (int x=0; x<dx.cols; x++, t+=3){
+            float fx = gx[x], fy = gy[x];
+            t[0] = fx*fx;
+            t[1] = fx*fy;
+            t[2] = fy*fy;
+        }
+    }
+    // Unnormalized sums and unscaled gradients only scale the response,
+    // which the 0..255 normalization cancels
+    cv::boxFilter(this->tensor, this->tensor, -1, cv::Size(this->blockSize, this->blockSize),
+                  cv::Point(-1,-1), false, cv::BORDER_REFLECT_101);
+
+    this->response.create(dx.size(), CV_32F);
+    float lowest=FLT_MAX, highest=-FLT_MAX, k=(float)this->k;
+    for (int y=0; y<dx.rows; y++){
+        const float *t = this->tensor.ptr<float>(y);
+        float *r = this->response.ptr<float>(y);
+        for (int x=0; x<dx.cols; x++, t+=3){
+            float trace = t[0]+t[2];
+            r[x] = t[0]*t[2] - t[1]*t[1] - k*trace*trace;
+            lowest = std::min(lowest, r[x]);
+            highest = std::max(highest, r[x]);
+        }
+    }
+    if (dx.rows<3 || dx.cols<3 || !(highest>lowest))
+        return this->corners;
+
+    // (int)normalized > threshold  <=>  normalized >= threshold+1
+    float minimum = lowest + (this->threshold+1)*(highest-lowest)/255.0f;
+    int stripes = std::max(1, std::min(4*cv::getNumThreads(), (dx.rows-2)/16));
+    this->stripeCorners.resize(stripes);
+    cv::parallel_for_(cv::Range(0, stripes), HarrisNmsBody(this, stripes, minimum));
+    for (int s=0; s<stripes; s++)
+        this->corners.insert(this->corners.end(), this->stripeCorners[s].begin(), this->stripeCorners[s].end());
+    return this->corners;
+}
+
+// Small ring around each corner, written straight into the pixels
+void HarrisDetector::drawCorners(cv::Mat &image, const std::vector<cv::Point> &corners, const cv::Scalar &color){
+    CV_Assert(image.type()==CV_8UC3);
+    cv::Vec3b c(cv::saturate_cast<uchar>(color[0]), cv::saturate_cast<uchar>(color[1]), cv::saturate_cast<uchar>(color[2]));
+    for (unsigned int i=0; i<corners.size(); i++){
+        cv::Point p = corners[i];
+        if (p.x<1 || p.y<1 || p.x>=image.cols-1 || p.y>=image.rows-1)
+            continue;
+        cv::Vec3b *above = image.ptr<cv::Vec3b>(p.y-1), *row = image.ptr<cv::Vec3b>(p.y), *below = image.ptr<cv::Vec3b>(p.y+1);
+        above[p.x-1]=c; above[p.x]=c; above[p.x+1]=c;
+        row[p.x-1]=c; row[p.x+1]=c;
+        below[p.x-1]=c; below[p.x]=c; below[p.x+1]=c;
+    }
+}
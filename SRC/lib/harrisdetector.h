@@ -0,0 +1,42 @@
+/*
+    @file: harrisdetector.h
+    @license: GNU General Public License
+    @author: Juan Manuel Perez Rua
+    @note: Code written for th practical module of
+    Visual Perception at the Université de Bourgogne
+*/
+
+#ifndef HARRISDETECTOR_H
+#define HARRISDETECTOR_H
+
+#include <vector>
+#include "opencv2/opencv.hpp"
+
+// Harris corners as a compact list of points. The structure tensor is
+// built from Sobel gradients the caller already has, summed over the block
+// with separable running sums (cost independent of the block size), and
+// the response det - k*trace^2 is computed in the same sweep as its range.
+// A second pass, parallel over stripes of rows, keeps the pixels whose
+// response normalized to 0..255 (as cornerHarris + normalize gave) is
+// above the threshold and that are the maximum of their 3x3 neighbourhood.
+class HarrisDetector{
+public:
+    HarrisDetector();
+    void setBlockSize(int blockSize);
+    void setK(double k);
+    void setThreshold(int threshold);
+    const std::vector<cv::Point> &detect(const cv::Mat &dx, const cv::Mat &dy);
+    static void drawCorners(cv::Mat &image, const std::vector<cv::Point> &corners, const cv::Scalar &color);
+private:
+    friend class HarrisNmsBody;
+    void suppress(int stripe, int stripes, float minimum);
+    int blockSize;
+    double k;
+    int threshold;
+    cv::Mat tensor;     // CV_32FC3 dx*dx, dx*dy, dy*dy, then their block sums
+    cv::Mat response;   // CV_32F
+    std::vector< std::vector<cv::Point> > stripeCorners;
+    std::vector<cv::Point> corners;
+};
+
+#endif // HARRISDETECTOR_H
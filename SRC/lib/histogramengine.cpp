@@ -0,0 +1,142 @@
+/*
+    @file: histogramengine.cpp
+    @license: GNU General Public License
+    @author: Juan Manuel Perez Rua
+    @note: Code written for th practical module of
+    Visual Perception at the Université de Bourgogne
+*/
+
+#include "histogramengine.h"
+#include <algorithm>
+
+class HistogramBody : public cv::ParallelLoopBody{
+public:
+    HistogramBody(HistogramEngine *engine, const cv::Mat &image, int stripes)
+        : engine(engine), image(image), stripes(stripes){}
+    void operator()(const cv::Range &range) const{
+        for (int s=range.start; s<range.end; s++)
+            this->engine->countStripe(this->image, s, this->stripes);
+    }
+private:
+    HistogramEngine *engine;
+    const cv::Mat &image;
+    int stripes;
+};
+
+HistogramEngine::HistogramEngine(){
+    this->step=1;
+    this->channels=0;
+    this->drawnChannels=0;
+    this->bins.assign(MAX_CHANNELS*BINS, 0);
+    setRange(-5, 260);
+}
+
+// Same value to bin mapping as calcHist on 8-bit data
+void HistogramEngine::setRange(float low, float high){
+    QMutexLocker locker(&this->mutex);
+    this->low=low;
+    this->high=high;
+    double a = BINS/(double(high)-low), b = -low*a;
+    for (int v=0; v<256; v++){
+        int bin = cvFloor(v*a+b);
+        this->binOf[v] = (bin>=0 && bin<BINS) ? bin : -1;
+    }
+}
+
+void HistogramEngine::setRoi(const cv::Rect &roi){
+    QMutexLocker locker(&this->mutex);
+    this->roi=roi;
+}
+
+// Count every step-th row and column only (1 = every pixel)
+void HistogramEngine::setSubsample(int step){
+    QMutexLocker locker(&this->mutex);
+    this->step = step<1 ? 1 : step;
+}
+
+void HistogramEngine::countStripe(const cv::Mat &image, int stripe, int stripes){
+    int cn = image.channels();
+    int *hist = &this->partial[stripe*MAX_CHANNELS*BINS];
+    std::fill(hist, hist+MAX_CHANNELS*BINS, 0);
+    int sampled = (image.rows+this->step-1)/this->step;
+    int start = stripe*sampled/stripes, end = (stripe+1)*sampled/stripes;
+    int pixelStep = this->step*cn;
+    for (int r=start; r<end; r++){
+        const uchar *p = image.ptr<uchar>(r*this->step);
+        const uchar *rowEnd = p + image.cols*cn;
+        for (; p<rowEnd; p+=pixelStep){
+            for (int c=0; c<cn; c++){
+                int bin = this->binOf[p[c]];
+                if (bin>=0)
+                    hist[c*BINS+bin]++;
+            }
+        }
+    }
+}
+
+// Count the frame, returns true when the bins differ from the previous frame
+bool HistogramEngine::compute(const cv::Mat &image){
+    QMutexLocker locker(&this->mutex);
+    if (image.empty() || image.depth()!=CV_8U || image.channels()>MAX_CHANNELS)
+        return false;
+    cv::Mat area = image;
+    if (this->roi.area()>0)
+        area = image(this->roi & cv::Rect(0, 0, image.cols, image.rows));
+    int sampled = (area.rows+this->step-1)/this->step;
+    int stripes = std::max(1, std::min(4*cv::getNumThreads(), sampled/16));
+    this->partial.resize(stripes*MAX_CHANNELS*BINS);
+    cv::parallel_for_(cv::Range(0, stripes), HistogramBody(this, area, stripes));
+
+    std::vector<int> merged(MAX_CHANNELS*BINS, 0);
+    for (int s=0; s<stripes; s++){
+        const int *hist = &this->partial[s*MAX_CHANNELS*BINS];
+        for (int i=0; i<MAX_CHANNELS*BINS; i++)
+            merged[i] += hist[i];
+    }
+    bool changed = merged!=this->bins || area.channels()!=this->channels;
+    this->bins.swap(merged);
+    this->channels = area.channels();
+    return changed;
+}
+
+int HistogramEngine::getChannels(){
+    QMutexLocker locker(&this->mutex);
+    return this->channels;
+}
+
+// Copy of the counts of one channel from the last compute()
+std::vector<int> HistogramEngine::getBins(int channel){
+    QMutexLocker locker(&this->mutex);
+    if (channel<0 || channel>=this->channels)
+        return std::vector<int>();
+    return std::vector<int>(this->bins.begin()+channel*BINS, this->bins.begin()+(channel+1)*BINS);
+}
+
+// 512x400 plot, each channel normalized to the plot height like the old
+// normalize(NORM_MINMAX) version and drawn in its own color
+const cv::Mat &HistogramEngine::draw(){
+    QMutexLocker locker(&this->mutex);
+    if (!this->plot.empty() && this->bins==this->drawnBins && this->channels==this->drawnChannels)
+        return this->plot;
+    const int width=512, height=400;
+    const int binWidth = cvRound((double)width/BINS);
+    static const cv::Scalar colors[MAX_CHANNELS] = {
+        cv::Scalar(255,0,0), cv::Scalar(0,255,0), cv::Scalar(0,0,255), cv::Scalar(255,255,255) };
+
+    int y[MAX_CHANNELS][BINS];
+    for (int c=0; c<this->channels; c++){
+        const int *hist = &this->bins[c*BINS];
+        int lowest = *std::min_element(hist, hist+BINS), highest = *std::max_element(hist, hist+BINS);
+        double scale = highest>lowest ? double(height)/(highest-lowest) : 0;
+        for (int i=0; i<BINS; i++)
+            y[c][i] = height - cvRound((float)((hist[i]-lowest)*scale));
+    }
+    this->plot.create(height, width, CV_8UC3);
+    this->plot.setTo(cv::Scalar(128,128,128));
+    for (int i=1; i<BINS; i++)
+        for (int c=0; c<this->channels; c++)
+            cv::line(this->plot, cv::Point(binWidth*(i-1), y[c][i-1]), cv::Point(binWidth*i, y[c][i]), colors[c], 4, 8, 0);
+    this->drawnBins = this->bins;
+    this->drawnChannels = this->channels;
+    return this->plot;
+}
@@ -0,0 +1,51 @@
+/*
+    @file: histogramengine.h
+    @license: GNU General Public License
+    @author: Juan Manuel Perez Rua
+    @note: Code written for th practical module of
+    Visual Perception at the Université de Bourgogne
+*/
+
+#ifndef HISTOGRAMENGINE_H
+#define HISTOGRAMENGINE_H
+
+#include <vector>
+#include <QMutex>
+#include "opencv2/opencv.hpp"
+
+// Per-channel histograms of 8-bit frames (up to 4 channels) and their plot.
+// All channels are counted in the same pass over the frame; stripes of rows
+// are counted in parallel into their own partial histograms, merged at the
+// end. Big frames can be restricted to a ROI and/or sampled every step-th
+// row and column. The plot lives in a persistent buffer that is only
+// redrawn when the bins changed since the last draw.
+// Bins are uniform over [low, high), 256 of them over [-5, 260) by default
+// (the range the GUI always used).
+class HistogramEngine{
+public:
+    enum{ BINS=256, MAX_CHANNELS=4 };
+    HistogramEngine();
+    void setRange(float low, float high);
+    void setRoi(const cv::Rect &roi);
+    void setSubsample(int step);
+    bool compute(const cv::Mat &image);
+    int getChannels();
+    std::vector<int> getBins(int channel);
+    const cv::Mat &draw();
+private:
+    void countStripe(const cv::Mat &image, int stripe, int stripes);
+    friend class HistogramBody;
+    QMutex mutex;       // bins and settings, for callers outside the processing thread
+    float low, high;
+    cv::Rect roi;       // empty: whole frame
+    int step;
+    int binOf[256];     // value -> bin, -1 when out of range
+    int channels;
+    std::vector<int> partial;   // stripes x MAX_CHANNELS x BINS
+    std::vector<int> bins;      // MAX_CHANNELS x BINS
+    std::vector<int> drawnBins; // bins the plot was drawn from
+    int drawnChannels;
+    cv::Mat plot;
+};
+
+#endif // HISTOGRAMENGINE_H
@@ -0,0 +1,226 @@
+/*
+    @file: linedetector.cpp
+    @license: GNU General Public License
+    @author: Juan Manuel Perez Rua
+    @note: Code written for th practical module of
+    Visual Perception at the Université de Bourgogne
+*/
+
+#include "linedetector.h"
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+#include <cmath>
+
+static const int NUM_ANGLES = 180; // one degree, like the old CV_PI/180
+static const unsigned int MAX_PEAKS = 1000; // strongest peaks walked per frame
+
+class VoteBody : public cv::ParallelLoopBody{
+public:
+    VoteBody(LineDetector *detector, int chunk) : detector(detector), chunk(chunk){}
+    void operator()(const cv::Range &range) const{
+        this->detector->vote(range.start*this->chunk, std::min(NUM_ANGLES, range.end*this->chunk));
+    }
+private:
+    LineDetector *detector;
+    int chunk;
+};
+
+struct Peak{
+    int votes, angle, rho;
+    bool operator<(const Peak &other) const{
+        if (this->votes!=other.votes)
+            return this->votes>other.votes;
+        return this->angle!=other.angle ? this->angle<other.angle : this->rho<other.rho;
+    }
+};
+
+LineDetector::LineDetector(){
+    this->threshold=50;
+    this->minLength=30;
+    this->maxGap=5;
+    this->tracking=false;
+    this->framesSinceDetection=REDETECT_FRAMES;
+    this->detectedEdgePixels=0;
+    this->lastFrame=0;
+    this->numRho=0;
+}
+
+// Votes a line needs to be looked at
+void LineDetector::setThreshold(int votes){
+    this->threshold = votes<1 ? 1 : votes;
+}
+
+void LineDetector::setSegments(double minLength, double maxGap){
+    this->minLength=minLength;
+    this->maxGap=maxGap;
+}
+
+void LineDetector::setTracking(bool tracking){
+    this->tracking=tracking;
+    this->framesSinceDetection=REDETECT_FRAMES;
+}
+
+void LineDetector::prepare(const cv::Size &size){
+    if (size==this->size)
+        return;
+    this->size=size;
+    this->numRho = 2*(size.width+size.height)+1;
+    this->accumulator.resize(NUM_ANGLES*this->numRho);
+    this->cosTable.resize(NUM_ANGLES);
+    this->sinTable.resize(NUM_ANGLES);
+    for (int a=0; a<NUM_ANGLES; a++){
+        this->cosTable[a] = (float)cos(a*CV_PI/NUM_ANGLES);
+        this->sinTable[a] = (float)sin(a*CV_PI/NUM_ANGLES);
+    }
+    this->framesSinceDetection=REDETECT_FRAMES;
+}
+
+void LineDetector::vote(int startAngle, int endAngle){
+    int offset = (this->numRho-1)/2;
+    for (int a=startAngle; a<endAngle; a++){
+        int *row = &this->accumulator[a*this->numRho];
+        memset(row, 0, this->numRho*sizeof(int));
+        float c = this->cosTable[a], s = this->sinTable[a];
+        for (unsigned int i=0; i<this->points.size(); i++)
+            row[cvRound(this->points[i].x*c + this->points[i].y*s) + offset]++;
+    }
+}
+
+/* Takes the votes of p back from every angle */
+void LineDetector::unvote(const cv::Point &p){
+    int offset = (this->numRho-1)/2;
+    for (int a=0; a<NUM_ANGLES; a++)
+        this->accumulator[a*this->numRho + cvRound(p.x*this->cosTable[a] + p.y*this->sinTable[a]) + offset]--;
+}
+
+/* Edge pixels of remaining along the line (angle, rho), one per step of the
+   major axis, accepting the two neighbours across the line; returns how many */
+int LineDetector::walk(const cv::Mat &edges, int angle, int rho){
+    float c = this->cosTable[angle], s = this->sinTable[angle];
+    bool horizontal = fabs(s)>fabs(c);
+    int length = horizontal ? edges.cols : edges.rows;
+    int across = horizontal ? edges.rows : edges.cols;
+    this->hits.clear();
+    for (int t=0; t<length; t++){
+        // x*c + y*s = rho, solved for the minor coordinate
+        int m = horizontal ? cvRound((rho - t*c)/s) : cvRound((rho - t*s)/c);
+        for (int d=0; d<3; d++){
+            int k = m + (d==0 ? 0 : (d==1 ? -1 : 1));
+            if (k<0 || k>=across)
+                continue;
+            int x = horizontal ? t : k, y = horizontal ? k : t;
+            if (edges.at<uchar>(y, x)){
+                this->hits.push_back(cv::Point(x, y));
+                break;
+            }
+        }
+    }
+    return this->hits.size();
+}
+
+/* Keep the previous segments while the edges still cover most of them */
+bool LineDetector::track(const cv::Mat &edges){
+    if (this->lines.empty() || this->framesSinceDetection>=REDETECT_FRAMES)
+        return false;
+    int edgePixels = cv::countNonZero(edges);
+    if (abs(edgePixels-this->detectedEdgePixels) > this->detectedEdgePixels/10)
+        return false;
+    for (unsigned int i=0; i<this->lines.size(); i++){
+        cv::LineIterator it(edges, cv::Point(this->lines[i][0], this->lines[i][1]),
+                            cv::Point(this->lines[i][2], this->lines[i][3]), 8);
+        int supported=0;
+        for (int p=0; p<it.count; p++, ++it){
+            cv::Point q = it.pos();
+            bool edge=false;
+            for (int dy=-1; dy<=1 && !edge; dy++)
+                for (int dx=-1; dx<=1 && !edge; dx++){
+                    cv::Point r(q.x+dx, q.y+dy);
+                    edge = r.x>=0 && r.y>=0 && r.x<edges.cols && r.y<edges.rows && edges.at<uchar>(r)!=0;
+                }
+            if (edge)
+                supported++;
+        }
+        if (supported*5 < it.count*4)
+            return false;
+    }
+    return true;
+}
+
+// Segments of a CV_8U edge plane (non-zero = edge) as x1,y1,x2,y2; frame
+// is the capture sequence number of the edges
+const std::vector<cv::Vec4i> &LineDetector::detect(const cv::Mat &edges, uint64 frame){
+    CV_Assert(edges.type()==CV_8U);
+    prepare(edges.size());
+    bool consecutive = frame==this->lastFrame+1;
+    this->lastFrame=frame;
+    if (this->tracking && consecutive && track(edges)){
+        this->framesSinceDetection++;
+        return this->lines;
+    }
+    this->lines.clear();
+
+    this->points.clear();
+    for (int y=0; y<edges.rows; y++){
+        const uchar *p = edges.ptr<uchar>(y);
+        for (int x=0; x<edges.cols; x++)
+            if (p[x])
+                this->points.push_back(cv::Point(x, y));
+    }
+    int chunk = std::max(1, NUM_ANGLES/(4*cv::getNumThreads()));
+    cv::parallel_for_(cv::Range(0, (NUM_ANGLES+chunk-1)/chunk), VoteBody(this, chunk));
+
+    /* Local maxima over the threshold, strongest first */
+    std::vector<Peak> peaks;
+    for (int a=0; a<NUM_ANGLES; a++){
+        const int *row = &this->accumulator[a*this->numRho];
+        const int *previous = a>0 ? row-this->numRho : NULL;
+        const int *next = a<NUM_ANGLES-1 ? row+this->numRho : NULL;
+        for (int r=1; r<this->numRho-1; r++){
+            int v = row[r];
+            if (v<this->threshold || v<row[r-1] || v<=row[r+1]
+                    || (previous && v<previous[r]) || (next && v<=next[r]))
+                continue;
+            Peak peak = { v, a, r-(this->numRho-1)/2 };
+            peaks.push_back(peak);
+        }
+    }
+    if (peaks.size()>MAX_PEAKS){
+        std::nth_element(peaks.begin(), peaks.begin()+MAX_PEAKS, peaks.end());
+        peaks.resize(MAX_PEAKS);
+    }
+    std::sort(peaks.begin(), peaks.end());
+
+    /* Cut each peak line into segments, claiming their pixels and their
+       votes; a peak left under the threshold by stronger lines is skipped */
+    edges.copyTo(this->remaining);
+    int offset = (this->numRho-1)/2;
+    double gap2 = (this->maxGap+1)*(this->maxGap+1), length2 = this->minLength*this->minLength;
+    for (unsigned int i=0; i<peaks.size(); i++){
+        if (this->accumulator[peaks[i].angle*this->numRho + peaks[i].rho + offset]<this->threshold)
+            continue;
+        if (walk(this->remaining, peaks[i].angle, peaks[i].rho)<this->threshold)
+            continue;
+        unsigned int start=0;
+        for (unsigned int j=1; j<=this->hits.size(); j++){
+            if (j<this->hits.size()){
+                cv::Point d = this->hits[j]-this->hits[j-1];
+                if (d.x*d.x+d.y*d.y <= gap2)
+                    continue;
+            }
+            cv::Point d = this->hits[j-1]-this->hits[start];
+            if (d.x*d.x+d.y*d.y >= length2){
+                this->lines.push_back(cv::Vec4i(this->hits[start].x, this->hits[start].y,
+                                                this->hits[j-1].x, this->hits[j-1].y));
+                for (unsigned int k=start; k<j; k++){
+                    this->remaining.at<uchar>(this->hits[k]) = 0;
+                    unvote(this->hits[k]);
+                }
+            }
+            start=j;
+        }
+    }
+    this->framesSinceDetection=0;
+    this->detectedEdgePixels=this->points.size();
+    return this->lines;
+}
@@ -0,0 +1,63 @@
+/*
+    @file: linedetector.h
+    @license: GNU General Public License
+    @author: Juan Manuel Perez Rua
+    @note: Code written for th practical module of
+    Visual Perception at the Université de Bourgogne
+*/
+
+#ifndef LINEDETECTOR_H
+#define LINEDETECTOR_H
+
+#include <vector>
+#include "opencv2/opencv.hpp"
+
+// Line segments of an edge plane, the HOUGH LINES replacement for
+// HoughLinesP. Every edge pixel votes in a (rho, theta) accumulator that
+// stays allocated between frames; the theta range is split between
+// threads so each one owns its accumulator rows and nothing has to be
+// merged. Peaks are then visited strongest first and the edge plane is
+// walked along each peak line to cut it into segments (gaps up to
+// maxGap, at least minLength long); pixels used by a segment are removed
+// and their votes taken back from the accumulator, as the progressive
+// transform does, so weaker peaks of the same line drop under the
+// threshold and are not walked at all. At most MAX_PEAKS peaks are
+// looked at per frame.
+// With tracking on, the segments of the previous frame are kept as long as
+// the edges still support them, and the full detection only runs again
+// when they stop doing so or every REDETECT_FRAMES frames. Only the result
+// of frame-1 is ever kept: after a gap in the frame numbers (a dropped
+// frame, or one processed by another detector) the frame is detected from
+// scratch, so the output does not depend on which frames a detector saw.
+class LineDetector{
+public:
+    enum{ REDETECT_FRAMES=10 };
+    LineDetector();
+    void setThreshold(int votes);
+    void setSegments(double minLength, double maxGap);
+    void setTracking(bool tracking);
+    const std::vector<cv::Vec4i> &detect(const cv::Mat &edges, uint64 frame);
+private:
+    friend class VoteBody;
+    void prepare(const cv::Size &size);
+    void vote(int startAngle, int endAngle);
+    bool track(const cv::Mat &edges);
+    int walk(const cv::Mat &edges, int angle, int rho);
+    void unvote(const cv::Point &p);
+    int threshold;
+    double minLength, maxGap;
+    bool tracking;
+    int framesSinceDetection;
+    int detectedEdgePixels;
+    uint64 lastFrame;               // frame number of the previous detect()
+    cv::Size size;
+    int numRho;
+    std::vector<float> cosTable, sinTable;
+    std::vector<int> accumulator;   // angle-major, numAngles x numRho
+    std::vector<cv::Point> points;  // edge pixels of the frame
+    std::vector<cv::Point> hits;    // edge pixels found along the walked line
+    cv::Mat remaining;              // edge pixels not claimed by a segment yet
+    std::vector<cv::Vec4i> lines;
+};
+
+#endif // LINEDETECTOR_H
@@ -0,0 +1,121 @@
+/*
+    @file: logocompositor.cpp
+    @license: GNU General Public License
+    @author: Juan Manuel Perez Rua
+    @note: Code written for th practical module of
+    Visual Perception at the Université de Bourgogne
+*/
+
+#include "logocompositor.h"
+#if CV_SSE2
+#include <emmintrin.h>
+#endif
+
+/* dst = (premultiplied + dst*frameWeight + 128) >> 8, for n bytes */
+static void blendRow(uchar *dst, const ushort *premultiplied, const ushort *frameWeight, int n){
+    int i=0;
+#if CV_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i half = _mm_set1_epi16(128);
+    for (; i<=n-16; i+=16){
+        __m128i d = _mm_loadu_si128((const __m128i*)(dst+i));
+        __m128i lo = _mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), _mm_loadu_si128((const __m128i*)(frameWeight+i)));
+        __m128i hi = _mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), _mm_loadu_si128((const __m128i*)(frameWeight+i+8)));
+        lo = _mm_adds_epu16(lo, _mm_loadu_si128((const __m128i*)(premultiplied+i)));
+        hi = _mm_adds_epu16(hi, _mm_loadu_si128((const __m128i*)(premultiplied+i+8)));
+        lo = _mm_srli_epi16(_mm_adds_epu16(lo, half), 8);
+        hi = _mm_srli_epi16(_mm_adds_epu16(hi, half), 8);
+        _mm_storeu_si128((__m128i*)(dst+i), _mm_packus_epi16(lo, hi));
+    }
+#endif
+    for (; i<n; i++){
+        int v = (premultiplied[i] + dst[i]*frameWeight[i] + 128) >> 8;
+        dst[i] = (uchar)(v>255 ? 255 : v);
+    }
+}
+
+LogoCompositor::LogoCompositor(){
+    this->x=0;
+    this->y=0;
+    this->transparency=50;
+}
+
+// Any 8/16 bit gray, BGR or BGRA image; kept as BGR or BGRA 8 bit
+void LogoCompositor::setLogo(const cv::Mat &logo){
+    this->cache.clear();
+    this->logo.release();
+    if (logo.empty())
+        return;
+    cv::Mat eight = logo;
+    if (logo.depth()==CV_16U)
+        logo.convertTo(eight, CV_8U, 1.0/256);
+    else if (logo.depth()!=CV_8U)
+        logo.convertTo(eight, CV_8U);
+    if (eight.channels()==1)
+        cv::cvtColor(eight, this->logo, CV_GRAY2BGR);
+    else
+        this->logo = eight;
+}
+
+void LogoCompositor::setPosition(double x, double y){
+    this->x=x;
+    this->y=y;
+}
+
+// Percentage of the frame that shows through the logo
+void LogoCompositor::setTransparency(int transparency){
+    if (transparency!=this->transparency)
+        this->cache.clear();
+    this->transparency=transparency;
+}
+
+// Scale the logo for this frame size and bake its weights (done once per size)
+const LogoCompositor::Prepared &LogoCompositor::prepare(const cv::Size &frameSize){
+    std::pair<int,int> key(frameSize.width, frameSize.height);
+    std::map< std::pair<int,int>, Prepared >::iterator it = this->cache.find(key);
+    if (it!=this->cache.end())
+        return it->second;
+
+    Prepared &p = this->cache[key];
+    cv::Size size(frameSize.width/5, frameSize.height/5);
+    if (size.area()==0)
+        return p;
+    cv::Mat scaled;
+    cv::resize(this->logo, scaled, size, 0, 0, CV_INTER_LINEAR);
+
+    double opacity = 1-(double)this->transparency/100;
+    p.premultiplied.create(size, CV_16UC3);
+    p.frameWeight.create(size, CV_16UC3);
+    int cn = scaled.channels();
+    for (int r=0; r<size.height; r++){
+        const uchar *src = scaled.ptr<uchar>(r);
+        ushort *pre = p.premultiplied.ptr<ushort>(r);
+        ushort *fw = p.frameWeight.ptr<ushort>(r);
+        for (int c=0; c<size.width; c++, src+=cn, pre+=3, fw+=3){
+            double a = cn==4 ? opacity*src[3]/255.0 : opacity;
+            int w = cvRound(a*256);
+            for (int k=0; k<3; k++){
+                pre[k] = (ushort)cvRound(src[k]*a*256);
+                fw[k] = (ushort)(256-w);
+            }
+        }
+    }
+    return p;
+}
+
+void LogoCompositor::compose(cv::Mat &frame){
+    if (this->logo.empty() || frame.type()!=CV_8UC3)
+        return;
+    const Prepared &p = prepare(frame.size());
+    if (p.premultiplied.empty())
+        return;
+    int cols = p.premultiplied.cols, rows = p.premultiplied.rows;
+    cv::Rect roi = cv::Rect( (frame.cols-cols)*(this->x/100),
+                             (frame.rows-rows)*(this->y/100),
+                             cols,
+                             rows );
+    roi &= cv::Rect(0, 0, frame.cols, frame.rows);
+    for (int r=0; r<roi.height; r++)
+        blendRow(frame.ptr<uchar>(roi.y+r)+3*roi.x, p.premultiplied.ptr<ushort>(r),
+                 p.frameWeight.ptr<ushort>(r), 3*roi.width);
+}
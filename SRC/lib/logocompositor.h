@@ -0,0 +1,40 @@
+/*
+    @file: logocompositor.h
+    @license: GNU General Public License
+    @author: Juan Manuel Perez Rua
+    @note: Code written for th practical module of
+    Visual Perception at the Université de Bourgogne
+*/
+
+#ifndef LOGOCOMPOSITOR_H
+#define LOGOCOMPOSITOR_H
+
+#include <map>
+#include <utility>
+#include "opencv2/opencv.hpp"
+
+// Blends a logo into frames. The logo is scaled to a fifth of the frame
+// like before, but the scaled copy is cached per frame size together with
+// its blending weights, already premultiplied by the transparency (and the
+// logo alpha channel when it has one). compose() then only touches the
+// logo ROI, in 8.8 fixed point, 16 bytes at a time when SSE2 is available.
+class LogoCompositor{
+public:
+    LogoCompositor();
+    void setLogo(const cv::Mat &logo);
+    void setPosition(double x, double y);
+    void setTransparency(int transparency);
+    void compose(cv::Mat &frame);
+private:
+    struct Prepared{
+        cv::Mat premultiplied; // CV_16UC3, logo*weight*256
+        cv::Mat frameWeight;   // CV_16UC3, (1-weight)*256
+    };
+    const Prepared &prepare(const cv::Size &frameSize);
+    std::map< std::pair<int,int>, Prepared > cache;
+    cv::Mat logo;   // 8UC3 or 8UC4
+    double x, y;    // position in percent of the free space
+    int transparency;
+};
+
+#endif // LOGOCOMPOSITOR_H
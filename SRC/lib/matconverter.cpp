@@ -0,0 +1,86 @@
+/*
+    @file: matconverter.cpp
+    @license: GNU General Public License
+    @author: Juan Manuel Perez Rua
+    @note: Code written for th practical module of
+    Visual Perception at the Université de Bourgogne
+*/
+
+#include "matconverter.h"
+#include <cstring>
+
+MatConverter::MatConverter(int poolSize){
+    this->pool.resize(poolSize>0 ? poolSize : 1);
+    this->next=0;
+    this->allocations=0;
+    for (int i=0; i<256; i++)
+        this->grayTable.push_back(qRgb(i,i,i));
+}
+
+// Number of QImages allocated since construction (should stop growing after warm-up)
+int MatConverter::getAllocations() const{
+    return this->allocations;
+}
+
+// Pick a pooled image nobody else is holding. QImage is implicitly shared, so
+// an image handed out on the previous call is only reused once the receiver
+// has dropped it; otherwise writing to bits() would detach (allocate) anyway.
+QImage &MatConverter::acquire(int width, int height, QImage::Format format){
+    unsigned int n = this->pool.size();
+    int freeSlot = -1;
+    for (unsigned int k=0; k<n; k++){
+        unsigned int i = (this->next+k)%n;
+        QImage &img = this->pool[i];
+        if (!img.isNull() && !img.isDetached())
+            continue;
+        if (!img.isNull() && img.width()==width && img.height()==height && img.format()==format){
+            this->next = (i+1)%n;
+            return img;
+        }
+        if (freeSlot<0)
+            freeSlot = i;
+    }
+    if (freeSlot<0)
+        freeSlot = this->next;
+    this->pool[freeSlot] = QImage(width, height, format);
+    if (format==QImage::Format_Indexed8)
+        this->pool[freeSlot].setColorTable(this->grayTable);
+    this->allocations++;
+    this->next = (freeSlot+1)%n;
+    return this->pool[freeSlot];
+}
+
+QImage MatConverter::convert(const cv::Mat &mat){
+    if (mat.empty())
+        return QImage();
+
+    if (mat.depth()!=CV_8U){
+        // Sobel/Laplacian style outputs: bring them back to 8 bits first
+        mat.convertTo(this->depthBuffer, CV_8U);
+        return convert(this->depthBuffer);
+    }
+
+    switch (mat.channels()){
+    case 1:{
+        QImage &image = acquire(mat.cols, mat.rows, QImage::Format_Indexed8);
+        cv::Mat wrapped(mat.rows, mat.cols, CV_8UC1, image.bits(), image.bytesPerLine());
+        mat.copyTo(wrapped);
+        return image;
+    }
+    case 3:{
+        QImage &image = acquire(mat.cols, mat.rows, QImage::Format_RGB888);
+        cv::Mat wrapped(mat.rows, mat.cols, CV_8UC3, image.bits(), image.bytesPerLine());
+        cv::cvtColor(mat, wrapped, CV_BGR2RGB);
+        return image;
+    }
+    case 4:{
+        // BGRA in memory is exactly what Format_RGB32 expects on little endian
+        QImage &image = acquire(mat.cols, mat.rows, QImage::Format_RGB32);
+        cv::Mat wrapped(mat.rows, mat.cols, CV_8UC4, image.bits(), image.bytesPerLine());
+        mat.copyTo(wrapped);
+        return image;
+    }
+    default:
+        return QImage();
+    }
+}
@@ -0,0 +1,35 @@
+/*
+    @file: matconverter.h
+    @license: GNU General Public License
+    @author: Juan Manuel Perez Rua
+    @note: Code written for th practical module of
+    Visual Perception at the Université de Bourgogne
+*/
+
+#ifndef MATCONVERTER_H
+#define MATCONVERTER_H
+
+#include <QImage>
+#include <QVector>
+#include "opencv2/opencv.hpp"
+
+// Converts cv::Mat frames to QImage without touching pixels one by one.
+// BGR frames go through a single cvtColor straight into the QImage bits
+// (Format_RGB888), gray frames are copied row by row into Format_Indexed8.
+// The QImages are kept in a small pool and reused while nobody else holds
+// a reference to them, so at a fixed resolution no allocation is needed.
+class MatConverter{
+public:
+    MatConverter(int poolSize=3);
+    QImage convert(const cv::Mat &mat);
+    int getAllocations() const;
+private:
+    QImage &acquire(int width, int height, QImage::Format format);
+    std::vector<QImage> pool;
+    QVector<QRgb> grayTable;
+    cv::Mat depthBuffer;
+    unsigned int next;
+    int allocations;
+};
+
+#endif // MATCONVERTER_H
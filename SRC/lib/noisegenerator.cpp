@@ -0,0 +1,213 @@
+/*
+    @file: noisegenerator.cpp
+    @license: GNU General Public License
+    @author: Juan Manuel Perez Rua
+    @note: Code written for th practical module of
+    Visual Perception at the Université de Bourgogne
+*/
+
+#include "noisegenerator.h"
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#if CV_SSE2
+#include <emmintrin.h>
+#endif
+
+/* Four xorshift32 generators side by side, 16 random bytes per call */
+class XorShift4{
+public:
+    XorShift4(unsigned int seed){
+        for (int i=0; i<4; i++){
+            // splitmix32 so neighbouring seeds give unrelated states
+            unsigned int z = (seed += 0x9E3779B9u);
+            z = (z ^ (z>>16)) * 0x85EBCA6Bu;
+            z = (z ^ (z>>13)) * 0xC2B2AE35u;
+            z ^= z>>16;
+            this->state[i] = z ? z : 0x6B43A9B5u;
+        }
+    }
+    void next(uchar out[16]){
+#if CV_SSE2
+        __m128i x = _mm_loadu_si128((const __m128i*)this->state);
+        x = _mm_xor_si128(x, _mm_slli_epi32(x, 13));
+        x = _mm_xor_si128(x, _mm_srli_epi32(x, 17));
+        x = _mm_xor_si128(x, _mm_slli_epi32(x, 5));
+        _mm_storeu_si128((__m128i*)this->state, x);
+        _mm_storeu_si128((__m128i*)out, x);
+#else
+        for (int i=0; i<4; i++){
+            unsigned int x = this->state[i];
+            x ^= x<<13;
+            x ^= x>>17;
+            x ^= x<<5;
+            this->state[i] = x;
+            out[4*i] = (uchar)x;
+            out[4*i+1] = (uchar)(x>>8);
+            out[4*i+2] = (uchar)(x>>16);
+            out[4*i+3] = (uchar)(x>>24);
+        }
+#endif
+    }
+private:
+    unsigned int state[4];
+};
+
+static unsigned int stripeSeed(unsigned int seed, quint64 frame, int stripe){
+    return seed ^ (unsigned int)(frame*0x9E3779B97F4A7C15ULL >> 32) ^ ((unsigned int)stripe*0x85EBCA77u);
+}
+
+static int maxValue8u(const cv::Mat &image){
+    int cols = image.cols*image.channels();
+    uchar best=0;
+    for (int r=0; r<image.rows; r++){
+        const uchar *p = image.ptr<uchar>(r);
+        int i=0;
+#if CV_SSE2
+        __m128i m = _mm_setzero_si128();
+        for (; i<=cols-16; i+=16)
+            m = _mm_max_epu8(m, _mm_loadu_si128((const __m128i*)(p+i)));
+        uchar lanes[16];
+        _mm_storeu_si128((__m128i*)lanes, m);
+        for (int k=0; k<16; k++)
+            best = std::max(best, lanes[k]);
+#endif
+        for (; i<cols; i++)
+            best = std::max(best, p[i]);
+    }
+    return best;
+}
+
+/** Stripe bodies **/
+class SaltPepperBody : public cv::ParallelLoopBody{
+public:
+    SaltPepperBody(cv::Mat &image, int power, unsigned int seed, quint64 frame)
+        : image(image), seed(seed), frame(frame){
+        this->low = 127*double(power)/100;      // u < low  -> pepper
+        this->high = 255-127*double(power)/100; // u > high -> salt
+    }
+    void operator()(const cv::Range &stripes) const{
+        int cn = this->image.channels();
+        uchar rnd[16];
+        for (int s=stripes.start; s<stripes.end; s++){
+            XorShift4 rng(stripeSeed(this->seed, this->frame, s));
+            int end = std::min(this->image.rows, (s+1)*NoiseGenerator::STRIPE_ROWS);
+            for (int r=s*NoiseGenerator::STRIPE_ROWS; r<end; r++){
+                uchar *p = this->image.ptr<uchar>(r);
+                for (int x=0; x<this->image.cols; x+=16){
+                    rng.next(rnd);
+                    int n = std::min(16, this->image.cols-x);
+                    for (int k=0; k<n; k++){
+                        double u = rnd[k];
+                        if (u<this->low)
+                            memset(p+(x+k)*cn, 0, cn);
+                        else if (u>this->high)
+                            memset(p+(x+k)*cn, 255, cn);
+                    }
+                }
+            }
+        }
+    }
+private:
+    cv::Mat &image;
+    unsigned int seed;
+    quint64 frame;
+    double low, high;
+};
+
+class GaussianBody : public cv::ParallelLoopBody{
+public:
+    GaussianBody(cv::Mat &image, const uchar *table, const uchar *scale, unsigned int seed, quint64 frame)
+        : image(image), table(table), scale(scale), seed(seed), frame(frame){}
+    void operator()(const cv::Range &stripes) const{
+        int cols = this->image.cols*this->image.channels();
+        const int shift = 16-NoiseGenerator::GAUSSIAN_LUT_BITS;
+        uchar rnd[16];
+        for (int s=stripes.start; s<stripes.end; s++){
+            XorShift4 rng(stripeSeed(this->seed, this->frame, s));
+            int end = std::min(this->image.rows, (s+1)*NoiseGenerator::STRIPE_ROWS);
+            for (int r=s*NoiseGenerator::STRIPE_ROWS; r<end; r++){
+                uchar *p = this->image.ptr<uchar>(r);
+                for (int i=0; i<cols; i+=8){
+                    rng.next(rnd);
+                    int n = std::min(8, cols-i);
+                    for (int k=0; k<n; k++){
+                        int sample = this->table[(rnd[2*k] | (rnd[2*k+1]<<8)) >> shift];
+                        p[i+k] = this->scale[sample + p[i+k]];
+                    }
+                }
+            }
+        }
+    }
+private:
+    cv::Mat &image;
+    const uchar *table;
+    const uchar *scale;
+    unsigned int seed;
+    quint64 frame;
+};
+
+/** NoiseGenerator **/
+NoiseGenerator::NoiseGenerator(unsigned int seed){
+    this->seed=seed;
+    this->tablePower=-1;
+    this->tableStddev=-1;
+    this->tableMax=0;
+}
+
+void NoiseGenerator::setSeed(unsigned int seed){
+    this->seed=seed;
+}
+
+// Same thresholds as the randu/compare/setTo version: a pixel turns black
+// when its uniform draw is under 127*power/100, white when over 255 minus that
+void NoiseGenerator::saltPepper(cv::Mat &image, int power, quint64 frame){
+    CV_Assert(image.depth()==CV_8U);
+    int stripes = (image.rows+STRIPE_ROWS-1)/STRIPE_ROWS;
+    cv::parallel_for_(cv::Range(0, stripes), SaltPepperBody(image, power, this->seed, frame));
+}
+
+// Inverse CDF of N(power/2, 255*stddev/100) sampled at 2^GAUSSIAN_LUT_BITS
+// points and saturated to 8 bits like randn into a CV_8U matrix. The tails
+// stop at +-3.7 sigma, so the largest noise value is known in advance.
+void NoiseGenerator::buildGaussianTable(int power, int stddev){
+    if (power==this->tablePower && stddev==this->tableStddev)
+        return;
+    int n = 1<<GAUSSIAN_LUT_BITS;
+    double mean = int(double(power)/2), sigma = 255*stddev/100;
+    this->gaussianTable.resize(n);
+    this->tableMax=0;
+    for (int i=0; i<n; i++){
+        // Bisection on erfc, plenty for a table built once per setting
+        double p = (i+0.5)/n, lo=-8, hi=8;
+        for (int it=0; it<60; it++){
+            double mid = 0.5*(lo+hi);
+            if (0.5*erfc(-mid/std::sqrt(2.0))<p) lo=mid; else hi=mid;
+        }
+        uchar v = cv::saturate_cast<uchar>(mean + sigma*0.5*(lo+hi));
+        this->gaussianTable[i] = v;
+        this->tableMax = std::max(this->tableMax, (int)v);
+    }
+    this->tablePower=power;
+    this->tableStddev=stddev;
+}
+
+// Largest value the Gaussian noise can take with the current table
+int NoiseGenerator::getGaussianBound() const{
+    return this->tableMax;
+}
+
+// image = (noise + image) * 255/(max(noise) + max(image)), as the
+// randn/minMaxLoc/addWeighted version did, but the noise is never stored:
+// max(noise) is the table bound and the scaling is a 511 entry table.
+void NoiseGenerator::gaussian(cv::Mat &image, int power, int stddev, quint64 frame){
+    CV_Assert(image.depth()==CV_8U);
+    buildGaussianTable(power, stddev);
+    double norm = this->tableMax + maxValue8u(image);
+    uchar scale[511];
+    for (int v=0; v<511; v++)
+        scale[v] = cv::saturate_cast<uchar>(norm>0 ? v*255/norm : 0);
+    int stripes = (image.rows+STRIPE_ROWS-1)/STRIPE_ROWS;
+    cv::parallel_for_(cv::Range(0, stripes),
+                      GaussianBody(image, &this->gaussianTable[0], scale, this->seed, frame));
+}
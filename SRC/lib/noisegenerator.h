@@ -0,0 +1,39 @@
+/*
+    @file: noisegenerator.h
+    @license: GNU General Public License
+    @author: Juan Manuel Perez Rua
+    @note: Code written for th practical module of
+    Visual Perception at the Université de Bourgogne
+*/
+
+#ifndef NOISEGENERATOR_H
+#define NOISEGENERATOR_H
+
+#include <vector>
+#include <QtGlobal>
+#include "opencv2/opencv.hpp"
+
+// Salt & pepper and Gaussian noise applied in place, in one pass over the
+// frame. Random numbers come from four interleaved xorshift32 generators
+// (one SSE2 register when available, same sequence without it); the frame
+// is cut in stripes of STRIPE_ROWS rows processed with cv::parallel_for_,
+// each with its own generator seeded from (seed, frame, stripe). The noise
+// of a given frame number is therefore the same whatever the number of
+// threads, which is what noise-robustness sweeps need.
+class NoiseGenerator{
+public:
+    enum{ STRIPE_ROWS=16, GAUSSIAN_LUT_BITS=12 };
+    NoiseGenerator(unsigned int seed=0x2545F491u);
+    void setSeed(unsigned int seed);
+    void saltPepper(cv::Mat &image, int power, quint64 frame);
+    void gaussian(cv::Mat &image, int power, int stddev, quint64 frame);
+    int getGaussianBound() const;
+private:
+    void buildGaussianTable(int power, int stddev);
+    unsigned int seed;
+    std::vector<uchar> gaussianTable; // inverse normal CDF, saturated to 8 bits
+    int tablePower, tableStddev;
+    int tableMax;
+};
+
+#endif // NOISEGENERATOR_H
@@ -0,0 +1,265 @@
+/*
+    @file: pipelineconfig.cpp
+    @license: GNU General Public License
+    @author: Juan Manuel Perez Rua
+    @note: Code written for th practical module of
+    Visual Perception at the Université de Bourgogne
+*/
+
+#include "pipelineconfig.h"
+#include <QStringList>
+
+PipelineConfig::PipelineConfig(){
+    this->logoActivated=false;
+    this->logoFilename="";
+    this->xlogo=0;
+    this->ylogo=0;
+    this->transparency=50;
+    this->addSaltPepperNoise=false;
+    this->addGaussianNoise=false;
+    this->noisePower=50;
+    this->noiseStdDev=50;
+    this->noiseSeed=0x2545F491u;
+    this->convertToGray=false;
+    this->equalizeHistogram=false;
+    this->rgbToHls=false;
+    this->rgbToHsv=false;
+    this->rgbToYcbcr=false;
+    this->rgbToXyz=false;
+    this->rgbToLuv=false;
+    this->rgbToLab=false;
+    this->morpho=MORPHO_NONE;
+    this->morphoSize=3;
+    this->filter=FILTER_NONE;
+    this->filterParam=50;
+    this->canny=false;
+    this->cannyParam1=50;
+    this->cannyParam2=50;
+    this->hough=HOUGH_NONE;
+    this->houghParam=50;
+    this->houghTracking=false;
+    this->houghMinRadius=0;
+    this->houghMaxRadius=0;
+    this->houghPyramid=0;
+    this->conObjs=false;
+    this->contours=false;
+    this->threshold=50;
+    this->shape=SHAPE_NONE;
+    this->feature=FEATURE_NONE;
+    this->featureParam=50;
+}
+
+PipelineSettings::PipelineSettings(){
+}
+
+int PipelineSettings::generation(){
+    return this->currentGeneration;
+}
+
+// Copy the configuration and return the generation it corresponds to
+int PipelineSettings::snapshot(PipelineConfig &out){
+    QMutexLocker locker(&this->mutex);
+    out = this->config;
+    return this->currentGeneration;
+}
+
+// To be called with mutex held, after editing config
+void PipelineSettings::changed(){
+    this->currentGeneration.ref();
+}
+
+MorphoType parseMorphoType(const QString &name){
+    if (name.compare("OPEN")==0) return MORPHO_OPEN;
+    if (name.compare("CLOSE")==0) return MORPHO_CLOSE;
+    if (name.compare("DILATE")==0) return MORPHO_DILATE;
+    if (name.compare("ERODE")==0) return MORPHO_ERODE;
+    return MORPHO_NONE;
+}
+
+FilterType parseFilterType(const QString &name){
+    if (name.compare("BLUR")==0) return FILTER_BLUR;
+    if (name.compare("SHARP")==0) return FILTER_SHARP;
+    if (name.compare("SOBEL")==0) return FILTER_SOBEL;
+    if (name.compare("LAPLACIAN")==0) return FILTER_LAPLACIAN;
+    return FILTER_NONE;
+}
+
+HoughType parseHoughType(const QString &name){
+    if (name.compare("LINES")==0) return HOUGH_LINES;
+    if (name.compare("CIRCLES")==0) return HOUGH_CIRCLES;
+    return HOUGH_NONE;
+}
+
+ShapeType parseShapeType(const QString &name){
+    if (name.compare("BOX")==0) return SHAPE_BOX;
+    if (name.compare("CIRCLE")==0) return SHAPE_CIRCLE;
+    if (name.compare("CENTER")==0) return SHAPE_CENTER;
+    return SHAPE_NONE;
+}
+
+FeatureType parseFeatureType(const QString &name){
+    if (name.compare("MSER")==0) return FEATURE_MSER;
+    if (name.compare("HARRIS")==0) return FEATURE_HARRIS;
+    if (name.compare("HARRIS_NMS")==0) return FEATURE_HARRIS_NMS;
+    if (name.compare("STAR")==0) return FEATURE_STAR;
+    if (name.compare("FAST")==0) return FEATURE_FAST;
+    if (name.compare("SIFT")==0) return FEATURE_SIFT;
+    if (name.compare("SURF")==0) return FEATURE_SURF;
+    return FEATURE_NONE;
+}
+
+StereoType parseStereoType(const QString &name){
+    if (name.compare("EPIPOLAR")==0) return STEREO_EPIPOLAR;
+    if (name.compare("HOMOGRAPHY")==0) return STEREO_HOMOGRAPHY;
+    if (name.compare("MOSAIC")==0) return STEREO_MOSAIC;
+    if (name.compare("MATCHES")==0) return STEREO_MATCHES;
+    return STEREO_NONE;
+}
+
+static bool parseFlag(const QString &value, bool &ok){
+    QString v = value.toLower();
+    ok = true;
+    if (v=="1" || v=="true" || v=="on" || v=="yes") return true;
+    if (v=="0" || v=="false" || v=="off" || v=="no") return false;
+    ok = false;
+    return false;
+}
+
+bool parsePipelineDescription(const QString &text, PipelineConfig &config, QString &error){
+    QStringList entries = QString(text).replace(';','\n').split('\n');
+    for (int i=0; i<entries.size(); i++){
+        QString entry = entries[i];
+        int comment = entry.indexOf('#');
+        if (comment>=0)
+            entry.truncate(comment);
+        entry = entry.trimmed();
+        if (entry.isEmpty())
+            continue;
+        int eq = entry.indexOf('=');
+        if (eq<=0){
+            error = QString("expected key = value: ").append(entry);
+            return false;
+        }
+        QString key = entry.left(eq).trimmed().toLower();
+        QString value = entry.mid(eq+1).trimmed();
+        QString name = value.toUpper();
+        bool ok = true;
+
+        if (key=="logo"){
+            config.logoActivated = !value.isEmpty();
+            config.logoFilename = value.toStdString();
+        }else if (key=="logo.x") config.xlogo = value.toDouble(&ok);
+        else if (key=="logo.y") config.ylogo = value.toDouble(&ok);
+        else if (key=="logo.transparency") config.transparency = value.toInt(&ok);
+        else if (key=="noise"){
+            config.addSaltPepperNoise = name=="SALTPEPPER" || name=="BOTH";
+            config.addGaussianNoise = name=="GAUSSIAN" || name=="BOTH";
+            ok = config.addSaltPepperNoise || config.addGaussianNoise || name=="NONE";
+        }
+        else if (key=="noise.power") config.noisePower = value.toInt(&ok);
+        else if (key=="noise.stddev") config.noiseStdDev = value.toInt(&ok);
+        else if (key=="noise.seed") config.noiseSeed = value.toUInt(&ok);
+        else if (key=="gray") config.convertToGray = parseFlag(value, ok);
+        else if (key=="equalize") config.equalizeHistogram = parseFlag(value, ok);
+        else if (key=="colorspace"){
+            config.rgbToHls = name=="HLS";
+            config.rgbToHsv = name=="HSV";
+            config.rgbToYcbcr = name=="YCBCR";
+            config.rgbToXyz = name=="XYZ";
+            config.rgbToLuv = name=="LUV";
+            config.rgbToLab = name=="LAB";
+            ok = name=="NONE" || config.rgbToHls || config.rgbToHsv || config.rgbToYcbcr
+                 || config.rgbToXyz || config.rgbToLuv || config.rgbToLab;
+        }
+        else if (key=="morpho"){
+            config.morpho = parseMorphoType(name);
+            ok = config.morpho!=MORPHO_NONE || name=="NONE";
+        }
+        else if (key=="morpho.size") config.morphoSize = value.toInt(&ok);
+        else if (key=="filter"){
+            config.filter = parseFilterType(name);
+            ok = config.filter!=FILTER_NONE || name=="NONE";
+        }
+        else if (key=="filter.param") config.filterParam = value.toDouble(&ok);
+        else if (key=="canny") config.canny = parseFlag(value, ok);
+        else if (key=="canny.low") config.cannyParam1 = value.toDouble(&ok);
+        else if (key=="canny.high") config.cannyParam2 = value.toDouble(&ok);
+        else if (key=="hough"){
+            config.hough = parseHoughType(name);
+            ok = config.hough!=HOUGH_NONE || name=="NONE";
+        }
+        else if (key=="hough.param") config.houghParam = value.toDouble(&ok);
+        else if (key=="hough.track") config.houghTracking = parseFlag(value, ok);
+        else if (key=="hough.minradius") config.houghMinRadius = value.toInt(&ok);
+        else if (key=="hough.maxradius") config.houghMaxRadius = value.toInt(&ok);
+        else if (key=="hough.pyramid"){
+            config.houghPyramid = value.toInt(&ok);
+            ok = ok && config.houghPyramid>=0 && config.houghPyramid<=4;
+        }
+        else if (key=="conobjs") config.conObjs = parseFlag(value, ok);
+        else if (key=="contours") config.contours = parseFlag(value, ok);
+        else if (key=="threshold") config.threshold = value.toDouble(&ok);
+        else if (key=="shape"){
+            config.shape = parseShapeType(name);
+            ok = config.shape!=SHAPE_NONE || name=="NONE";
+        }
+        else if (key=="feature"){
+            config.feature = parseFeatureType(name);
+            ok = config.feature!=FEATURE_NONE || name=="NONE";
+        }
+        else if (key=="feature.param") config.featureParam = value.toDouble(&ok);
+        else{
+            error = QString("unknown key: ").append(key);
+            return false;
+        }
+        if (!ok){
+            error = QString("bad value for ").append(key).append(": ").append(value);
+            return false;
+        }
+    }
+    return true;
+}
+
+/* Inverse of parsePipelineDescription for the settings that are active */
+QString describePipeline(const PipelineConfig &config){
+    static const char *morphos[] = { "NONE", "OPEN", "CLOSE", "DILATE", "ERODE" };
+    static const char *filters[] = { "NONE", "BLUR", "SHARP", "SOBEL", "LAPLACIAN" };
+    static const char *houghs[] = { "NONE", "LINES", "CIRCLES" };
+    static const char *shapes[] = { "NONE", "BOX", "CIRCLE", "CENTER" };
+    static const char *features[] = { "NONE", "MSER", "HARRIS", "HARRIS_NMS", "STAR", "FAST", "SIFT", "SURF" };
+    QStringList out;
+    if (config.logoActivated)
+        out << QString("logo = %1; logo.x = %2; logo.y = %3; logo.transparency = %4")
+               .arg(QString::fromStdString(config.logoFilename)).arg(config.xlogo).arg(config.ylogo).arg(config.transparency);
+    if (config.addSaltPepperNoise || config.addGaussianNoise)
+        out << QString("noise = %1; noise.power = %2; noise.stddev = %3; noise.seed = %4")
+               .arg(config.addSaltPepperNoise && config.addGaussianNoise ? "BOTH" : (config.addSaltPepperNoise ? "SALTPEPPER" : "GAUSSIAN"))
+               .arg(config.noisePower).arg(config.noiseStdDev).arg(config.noiseSeed);
+    if (config.convertToGray) out << "gray = 1";
+    if (config.equalizeHistogram) out << "equalize = 1";
+    if (config.rgbToHls) out << "colorspace = HLS";
+    if (config.rgbToHsv) out << "colorspace = HSV";
+    if (config.rgbToYcbcr) out << "colorspace = YCBCR";
+    if (config.rgbToXyz) out << "colorspace = XYZ";
+    if (config.rgbToLuv) out << "colorspace = LUV";
+    if (config.rgbToLab) out << "colorspace = LAB";
+    if (config.morpho!=MORPHO_NONE)
+        out << QString("morpho = %1; morpho.size = %2").arg(morphos[config.morpho]).arg(config.morphoSize);
+    if (config.filter!=FILTER_NONE)
+        out << QString("filter = %1; filter.param = %2").arg(filters[config.filter]).arg(config.filterParam);
+    if (config.canny)
+        out << QString("canny = 1; canny.low = %1; canny.high = %2").arg(config.cannyParam1).arg(config.cannyParam2);
+    if (config.hough!=HOUGH_NONE)
+        out << QString("hough = %1; hough.param = %2; hough.track = %3; hough.minradius = %4; hough.maxradius = %5; hough.pyramid = %6")
+               .arg(houghs[config.hough]).arg(config.houghParam).arg(config.houghTracking ? 1 : 0)
+               .arg(config.houghMinRadius).arg(config.houghMaxRadius).arg(config.houghPyramid);
+    if (config.conObjs) out << "conobjs = 1";
+    if (config.contours) out << "contours = 1";
+    if (config.conObjs || config.contours || config.shape!=SHAPE_NONE)
+        out << QString("threshold = %1").arg(config.threshold);
+    if (config.shape!=SHAPE_NONE)
+        out << QString("shape = %1").arg(shapes[config.shape]);
+    if (config.feature!=FEATURE_NONE)
+        out << QString("feature = %1; feature.param = %2").arg(features[config.feature]).arg(config.featureParam);
+    return out.join("\n");
+}
@@ -0,0 +1,113 @@
+/*
+    @file: pipelineconfig.h
+    @license: GNU General Public License
+    @author: Juan Manuel Perez Rua
+    @note: Code written for th practical module of
+    Visual Perception at the Université de Bourgogne
+*/
+
+#ifndef PIPELINECONFIG_H
+#define PIPELINECONFIG_H
+
+#include <QString>
+#include <QMutex>
+#include <QAtomicInt>
+#include <string>
+#include "opencv2/core/core.hpp"
+
+enum MorphoType{ MORPHO_NONE, MORPHO_OPEN, MORPHO_CLOSE, MORPHO_DILATE, MORPHO_ERODE };
+enum FilterType{ FILTER_NONE, FILTER_BLUR, FILTER_SHARP, FILTER_SOBEL, FILTER_LAPLACIAN };
+enum HoughType{ HOUGH_NONE, HOUGH_LINES, HOUGH_CIRCLES };
+enum ShapeType{ SHAPE_NONE, SHAPE_BOX, SHAPE_CIRCLE, SHAPE_CENTER };
+enum FeatureType{ FEATURE_NONE, FEATURE_MSER, FEATURE_HARRIS, FEATURE_HARRIS_NMS,
+                  FEATURE_STAR, FEATURE_FAST, FEATURE_SIFT, FEATURE_SURF };
+enum StereoType{ STEREO_NONE, STEREO_EPIPOLAR, STEREO_HOMOGRAPHY, STEREO_MOSAIC, STEREO_MATCHES };
+
+// Everything the per-frame processing chain depends on. The GUI setters of
+// ComputerVisionInterface edit one of these; the ProcessingPipeline is
+// rebuilt from a copy of it whenever it changes.
+struct PipelineConfig{
+    PipelineConfig();
+
+    bool logoActivated;
+    std::string logoFilename;
+    cv::Mat logoImage;   // decoded once, shared by every copy of the config
+    double xlogo;
+    double ylogo;
+    int transparency;
+
+    bool addSaltPepperNoise;
+    bool addGaussianNoise;
+    int noisePower;   /*min=0, max=99*/
+    int noiseStdDev;  /*min=0, max=99*/
+    unsigned int noiseSeed; // same seed and frame number, same noise
+
+    bool convertToGray;
+    bool equalizeHistogram;
+    bool rgbToHls;
+    bool rgbToHsv;
+    bool rgbToYcbcr;
+    bool rgbToXyz;
+    bool rgbToLuv;
+    bool rgbToLab;
+
+    MorphoType morpho;
+    int morphoSize;
+    FilterType filter;
+    double filterParam;
+
+    bool canny;
+    double cannyParam1;
+    double cannyParam2;
+    HoughType hough;
+    double houghParam;
+    bool houghTracking; // keep the previous lines/circles while the edges support them,
+                        // processing then runs on a single stream worker
+    int houghMinRadius; // circles, in pixels of the frame
+    int houghMaxRadius; // 0: no limit
+    int houghPyramid;   // circles are searched on the frame halved this many times
+
+    bool conObjs;
+    bool contours;
+    double threshold;
+    ShapeType shape;
+    FeatureType feature;
+    double featureParam;
+};
+
+// PipelineConfig shared between the GUI setters and the threads running
+// pipelines. Writers edit config while holding mutex and call changed();
+// readers compare generation() with the one they built from and take a
+// snapshot() when it moved.
+class PipelineSettings{
+public:
+    PipelineSettings();
+    int generation();
+    int snapshot(PipelineConfig &out);
+    void changed();
+    QMutex mutex;
+    PipelineConfig config;
+private:
+    QAtomicInt currentGeneration;
+};
+
+/* Names used by the GUI ("NONE", "BLUR", ...) to enum values */
+MorphoType parseMorphoType(const QString &name);
+FilterType parseFilterType(const QString &name);
+HoughType parseHoughType(const QString &name);
+ShapeType parseShapeType(const QString &name);
+FeatureType parseFeatureType(const QString &name);
+StereoType parseStereoType(const QString &name);
+
+/* Text form of a PipelineConfig, one "key = value" per line or separated by
+   ';', '#' starts a comment. Keys: logo, logo.x, logo.y, logo.transparency,
+   noise (SALTPEPPER|GAUSSIAN|BOTH), noise.power, noise.stddev, noise.seed, gray,
+   equalize, colorspace (HLS|HSV|YCBCR|XYZ|LUV|LAB), morpho, morpho.size,
+   filter, filter.param, canny, canny.low, canny.high, hough, hough.param, hough.track,
+   hough.minradius, hough.maxradius, hough.pyramid (0..4),
+   conobjs, contours, threshold, shape, feature, feature.param.
+   Enum values use the names the GUI uses. */
+bool parsePipelineDescription(const QString &text, PipelineConfig &config, QString &error);
+QString describePipeline(const PipelineConfig &config);
+
+#endif // PIPELINECONFIG_H
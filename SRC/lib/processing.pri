@@ -0,0 +1,53 @@
+#-------------------------------------------------
+#
+# Frame processing chain shared by the GUI, the batch tool and the
+# benchmarks (no GUI dependencies beyond QtCore)
+#
+#-------------------------------------------------
+
+INCLUDEPATH += $$PWD
+
+SOURCES += $$PWD/pipelineconfig.cpp \
+        $$PWD/processingstages.cpp \
+        $$PWD/processingpipeline.cpp \
+        $$PWD/framesource.cpp \
+        $$PWD/streampipeline.cpp \
+        $$PWD/stageprofiler.cpp \
+        $$PWD/framebufferpool.cpp \
+        $$PWD/logocompositor.cpp \
+        $$PWD/noisegenerator.cpp \
+        $$PWD/colorchain.cpp \
+        $$PWD/framefilter.cpp \
+        $$PWD/rectmorphology.cpp \
+        $$PWD/histogramengine.cpp \
+        $$PWD/componentlabeller.cpp \
+        $$PWD/linedetector.cpp \
+        $$PWD/circledetector.cpp \
+        $$PWD/harrisdetector.cpp \
+        $$PWD/detectorregistry.cpp \
+        $$PWD/hammingmatcher.cpp \
+        $$PWD/robustestimator.cpp \
+        $$PWD/gradientcanny.cpp
+
+HEADERS += $$PWD/pipelineconfig.h \
+        $$PWD/processingstages.h \
+        $$PWD/processingpipeline.h \
+        $$PWD/boundedqueue.h \
+        $$PWD/framesource.h \
+        $$PWD/streampipeline.h \
+        $$PWD/stageprofiler.h \
+        $$PWD/framebufferpool.h \
+        $$PWD/logocompositor.h \
+        $$PWD/noisegenerator.h \
+        $$PWD/colorchain.h \
+        $$PWD/framefilter.h \
+        $$PWD/rectmorphology.h \
+        $$PWD/histogramengine.h \
+        $$PWD/componentlabeller.h \
+        $$PWD/linedetector.h \
+        $$PWD/circledetector.h \
+        $$PWD/harrisdetector.h \
+        $$PWD/detectorregistry.h \
+        $$PWD/hammingmatcher.h \
+        $$PWD/robustestimator.h \
+        $$PWD/gradientcanny.h
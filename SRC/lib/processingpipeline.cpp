@@ -0,0 +1,185 @@
+/*
+    @file: processingpipeline.cpp
+    @license: GNU General Public License
+    @author: Juan Manuel Perez Rua
+    @note: Code written for th practical module of
+    Visual Perception at the Université de Bourgogne
+*/
+
+#include "processingpipeline.h"
+
+ProcessingPipeline::ProcessingPipeline(){
+    this->context.pool=&this->pool;
+    this->profiler=NULL;
+    this->frameAllocations=0;
+}
+
+// Stages are timed into profiler (may be NULL to disable timing)
+void ProcessingPipeline::setProfiler(StageProfiler *profiler){
+    this->profiler=profiler;
+}
+
+void ProcessingPipeline::add(ProcessingStage *stage, ProfileBlock block){
+    this->stages.push_back(stage);
+    this->blocks.push_back(block);
+}
+
+/* Translate the configuration into the ordered list of stages */
+void ProcessingPipeline::build(const PipelineConfig &config){
+    this->stages.clear();
+    this->blocks.clear();
+
+    if (config.logoActivated){
+        // Decoded by setLogo() in the GUI; headless configs only carry the name
+        cv::Mat logo = config.logoImage;
+        if (logo.empty() && !config.logoFilename.empty())
+            logo = cv::imread(config.logoFilename, CV_LOAD_IMAGE_UNCHANGED);
+        if (!logo.empty())
+            add(new LogoStage(logo, config.xlogo, config.ylogo, config.transparency), PROFILE_LOGO);
+    }
+    if (config.addSaltPepperNoise)
+        add(new SaltPepperNoiseStage(config.noisePower, config.noiseSeed), PROFILE_NOISE);
+    if (config.addGaussianNoise)
+        add(new GaussianNoiseStage(config.noisePower, config.noiseStdDev, config.noiseSeed), PROFILE_NOISE);
+    std::vector<int> colorCodes;
+    if (config.rgbToHls) colorCodes.push_back(CV_BGR2HLS);
+    if (config.rgbToHsv) colorCodes.push_back(CV_BGR2HSV);
+    if (config.rgbToYcbcr) colorCodes.push_back(CV_BGR2YCrCb);
+    if (config.rgbToXyz) colorCodes.push_back(CV_BGR2XYZ);
+    if (config.rgbToLuv) colorCodes.push_back(CV_BGR2Luv);
+    if (config.rgbToLab) colorCodes.push_back(CV_BGR2Lab);
+    if (config.convertToGray || config.equalizeHistogram || !colorCodes.empty())
+        add(new ColorStage(config.convertToGray, config.equalizeHistogram, colorCodes), PROFILE_COLOR);
+
+    switch (config.morpho){
+    case MORPHO_OPEN:
+        add(new MorphologyStage(cv::MORPH_OPEN, config.morphoSize), PROFILE_MORPHOLOGY);
+        break;
+    case MORPHO_CLOSE:
+        add(new MorphologyStage(cv::MORPH_CLOSE, config.morphoSize), PROFILE_MORPHOLOGY);
+        break;
+    case MORPHO_DILATE:
+        add(new MorphologyStage(cv::MORPH_DILATE, config.morphoSize), PROFILE_MORPHOLOGY);
+        break;
+    case MORPHO_ERODE:
+        add(new MorphologyStage(cv::MORPH_ERODE, config.morphoSize), PROFILE_MORPHOLOGY);
+        break;
+    default:
+        break;
+    }
+
+    switch (config.filter){
+    case FILTER_BLUR:
+        add(new BlurStage(config.filterParam), PROFILE_FILTER);
+        break;
+    case FILTER_SHARP:
+        add(new SharpStage(config.filterParam), PROFILE_FILTER);
+        break;
+    case FILTER_SOBEL:
+        add(new SobelStage(config.filterParam), PROFILE_FILTER);
+        break;
+    case FILTER_LAPLACIAN:
+        add(new LaplacianStage(config.filterParam), PROFILE_FILTER);
+        break;
+    default:
+        break;
+    }
+
+    if (config.canny)
+        add(new CannyStage(config.cannyParam1, config.cannyParam2), PROFILE_CANNY);
+
+    switch (config.hough){
+    case HOUGH_LINES:
+        add(new HoughLinesStage(config.cannyParam1, config.cannyParam2, config.houghParam, config.houghTracking), PROFILE_HOUGH);
+        break;
+    case HOUGH_CIRCLES:
+        add(new HoughCirclesStage(config.cannyParam1, config.cannyParam2, config.houghParam,
+                                  config.houghMinRadius, config.houghMaxRadius, config.houghPyramid,
+                                  config.houghTracking), PROFILE_HOUGH);
+        break;
+    default:
+        break;
+    }
+
+    if (config.conObjs)
+        add(new ConnectedObjectsStage(config.threshold), PROFILE_CONTOURS);
+    if (config.contours)
+        add(new ContoursStage(config.threshold), PROFILE_CONTOURS);
+    if (config.shape!=SHAPE_NONE)
+        add(new ShapeStage(config.shape, config.threshold), PROFILE_CONTOURS);
+
+    switch (config.feature){
+    case FEATURE_MSER:
+        add(new MserStage(this->detectors.mser()), PROFILE_FEATURES);
+        break;
+    case FEATURE_HARRIS:
+        add(new HarrisStage(config.featureParam), PROFILE_FEATURES);
+        break;
+    case FEATURE_HARRIS_NMS:
+        add(new HarrisNmsStage(config.featureParam), PROFILE_FEATURES);
+        break;
+    case FEATURE_STAR:
+        add(new KeypointStage(this->detectors.detector(DETECTOR_STAR, 10*config.featureParam/100),
+                              cv::Scalar(0,255,255), "star"), PROFILE_FEATURES);
+        break;
+    case FEATURE_FAST:
+        add(new FastStage(config.featureParam), PROFILE_FEATURES);
+        break;
+    case FEATURE_SIFT:
+        add(new KeypointStage(this->detectors.detector(DETECTOR_SIFT, config.featureParam+1),
+                              cv::Scalar(0,0,255), "sift"), PROFILE_FEATURES);
+        break;
+    case FEATURE_SURF:
+        add(new KeypointStage(this->detectors.detector(DETECTOR_SURF, 255*config.featureParam/100+1),
+                              cv::Scalar(0,255,0), "surf"), PROFILE_FEATURES);
+        break;
+    default:
+        break;
+    }
+}
+
+// Stages that only draw overlays keep the derived planes of the context valid
+void ProcessingPipeline::applyStage(int i){
+    this->stages[i]->apply(this->context);
+    if (this->stages[i]->modifiesImage())
+        this->context.invalidate();
+}
+
+/* Per-frame hot path: copy the frame into the working buffer and run every stage.
+   frameNumber seeds the noise stages; 0 just counts the calls. */
+cv::Mat &ProcessingPipeline::run(const cv::Mat &frame, quint64 frameNumber){
+    int pooled = this->pool.getAllocations();
+    const uchar *working = this->context.image.data;
+    this->context.source = &frame;
+    this->context.frameNumber = frameNumber ? frameNumber : this->context.frameNumber+1;
+    frame.copyTo(this->context.image);
+    this->frameAllocations = this->context.image.data!=working ? 1 : 0;
+    if (frame.empty())
+        return this->context.image;
+    this->context.invalidate();
+    if (this->profiler==NULL){
+        for (unsigned int i=0; i<this->stages.size(); i++)
+            applyStage(i);
+    }else{
+        ScopedTimer frameTimer(this->profiler, PROFILE_FRAME);
+        for (unsigned int i=0; i<this->stages.size(); i++){
+            ScopedTimer timer(this->profiler, this->blocks[i]);
+            applyStage(i);
+        }
+    }
+    this->frameAllocations += this->pool.getAllocations()-pooled;
+    return this->context.image;
+}
+
+int ProcessingPipeline::size() const{
+    return this->stages.size();
+}
+
+// Buffers allocated by the last run(): working image plus pool misses
+int ProcessingPipeline::getFrameAllocations() const{
+    return this->frameAllocations;
+}
+
+const ProcessingStage *ProcessingPipeline::stage(int i) const{
+    return this->stages[i];
+}
@@ -0,0 +1,46 @@
+/*
+    @file: processingpipeline.h
+    @license: GNU General Public License
+    @author: Juan Manuel Perez Rua
+    @note: Code written for th practical module of
+    Visual Perception at the Université de Bourgogne
+*/
+
+#ifndef PROCESSINGPIPELINE_H
+#define PROCESSINGPIPELINE_H
+
+#include <vector>
+#include "opencv2/opencv.hpp"
+#include "pipelineconfig.h"
+#include "processingstages.h"
+#include "stageprofiler.h"
+#include "detectorregistry.h"
+
+// Flat list of processing stages compiled from a PipelineConfig. build() is
+// only called when the configuration changes; run() just walks the list.
+// Stage scratch buffers come from a pool owned by the pipeline, so at a
+// fixed resolution getFrameAllocations() drops to zero after warm-up.
+// Feature detectors come from a registry that outlives build(), so they
+// are only reconstructed when the feature parameter changes.
+class ProcessingPipeline{
+public:
+    ProcessingPipeline();
+    void build(const PipelineConfig &config);
+    void setProfiler(StageProfiler *profiler);
+    cv::Mat &run(const cv::Mat &frame, quint64 frameNumber=0);
+    int size() const;
+    int getFrameAllocations() const;
+    const ProcessingStage *stage(int i) const;
+private:
+    void add(ProcessingStage *stage, ProfileBlock block);
+    void applyStage(int i);
+    std::vector< cv::Ptr<ProcessingStage> > stages;
+    std::vector<ProfileBlock> blocks;
+    StageProfiler *profiler;
+    FrameContext context;
+    FrameBufferPool pool;
+    DetectorRegistry detectors;
+    int frameAllocations;
+};
+
+#endif // PROCESSINGPIPELINE_H
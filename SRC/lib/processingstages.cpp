@@ -0,0 +1,382 @@
+/*
+    @file: processingstages.cpp
+    @license: GNU General Public License
+    @author: Juan Manuel Perez Rua
+    @note: Code written for th practical module of
+    Visual Perception at the Université de Bourgogne
+*/
+
+#include "processingstages.h"
+#include <algorithm>
+
+FrameContext::FrameContext(){
+    this->source=NULL;
+    this->pool=NULL;
+    this->frameNumber=0;
+    this->edgesPinned=false;
+    invalidate();
+}
+
+// image changed: every derived plane has to be recomputed
+void FrameContext::invalidate(){
+    this->grayValid=false;
+    this->binaryThreshold=-1;
+    this->contoursThreshold=-1;
+    this->componentsThreshold=-1;
+    this->componentCircles=false;
+    this->gradientsValid=false;
+    if (!this->edgesPinned)
+        this->edgesValid=false;
+    this->edgesPinned=false;
+}
+
+// Keep edges() through the next invalidate(): the stage that replaces the
+// image by its edges calls this so the line detector still gets the edges
+// of the frame, not the edges of the edges
+void FrameContext::pinEdges(){
+    this->edgesPinned=true;
+}
+
+const cv::Mat &FrameContext::gray(){
+    if (!this->grayValid){
+        if (this->image.channels()==1)
+            this->grayPlane = this->image;
+        else
+            cv::cvtColor(this->image, this->grayPlane, CV_BGR2GRAY);
+        this->grayValid=true;
+    }
+    return this->grayPlane;
+}
+
+// gray() thresholded at threshold percent (0..100)
+const cv::Mat &FrameContext::binary(double threshold){
+    if (this->binaryThreshold!=threshold){
+        cv::threshold(gray(), this->binaryPlane, 255*threshold/100, 255, CV_THRESH_BINARY);
+        this->binaryThreshold=threshold;
+    }
+    return this->binaryPlane;
+}
+
+// External contours of binary(threshold)
+const ContourList &FrameContext::contours(double threshold){
+    if (this->contoursThreshold!=threshold){
+        // findContours scribbles over its input
+        cv::Mat scratch = borrow(CV_8U);
+        binary(threshold).copyTo(scratch);
+        this->contourList.clear();
+        cv::findContours(scratch, this->contourList, CV_RETR_EXTERNAL, CV_CHAIN_APPROX_NONE);
+        this->contoursThreshold=threshold;
+    }
+    return this->contourList;
+}
+
+// Connected components of binary(threshold), with enclosing circles if asked
+const std::vector<Component> &FrameContext::components(double threshold, bool circles){
+    if (this->componentsThreshold!=threshold || (circles && !this->componentCircles)){
+        this->labeller.analyze(binary(threshold), circles);
+        this->componentsThreshold=threshold;
+        this->componentCircles=circles;
+    }
+    return this->labeller.getComponents();
+}
+
+// Canny edges of image (hysteresis thresholds low and high)
+const cv::Mat &FrameContext::edges(double low, double high){
+    if (!this->edgesValid || this->edgesLow!=low || this->edgesHigh!=high){
+        cv::Canny(this->image, this->edgePlane, low, high);
+        this->edgesLow=low;
+        this->edgesHigh=high;
+        this->edgesValid=true;
+    }
+    return this->edgePlane;
+}
+
+void FrameContext::computeGradients(){
+    if (this->gradientsValid)
+        return;
+    cv::Sobel(gray(), this->dxPlane, CV_16S, 1, 0, 3);
+    cv::Sobel(gray(), this->dyPlane, CV_16S, 0, 1, 3);
+    this->gradientsValid=true;
+}
+
+// 3x3 Sobel derivatives of gray() along x and y, CV_16S
+const cv::Mat &FrameContext::gradientX(){
+    computeGradients();
+    return this->dxPlane;
+}
+
+const cv::Mat &FrameContext::gradientY(){
+    computeGradients();
+    return this->dyPlane;
+}
+
+// Scratch buffer of the frame size, given back when the caller drops it
+cv::Mat FrameContext::borrow(int type){
+    if (this->pool==NULL)
+        return cv::Mat(this->image.size(), type);
+    return this->pool->acquire(this->image.size(), type);
+}
+
+/** Preprocessing **/
+LogoStage::LogoStage(const cv::Mat &logo, double x, double y, int transparency){
+    this->compositor.setLogo(logo);
+    this->compositor.setPosition(x, y);
+    this->compositor.setTransparency(transparency);
+}
+
+void LogoStage::apply(FrameContext &ctx){
+    this->compositor.compose(ctx.image);
+}
+
+SaltPepperNoiseStage::SaltPepperNoiseStage(int power, unsigned int seed) : generator(seed){
+    this->power=power;
+}
+
+void SaltPepperNoiseStage::apply(FrameContext &ctx){
+    this->generator.saltPepper(ctx.image, this->power, ctx.frameNumber);
+}
+
+GaussianNoiseStage::GaussianNoiseStage(int power, int stddev, unsigned int seed) : generator(seed){
+    this->power=power;
+    this->stddev=stddev;
+}
+
+void GaussianNoiseStage::apply(FrameContext &ctx){
+    this->generator.gaussian(ctx.image, this->power, this->stddev, ctx.frameNumber);
+}
+
+ColorStage::ColorStage(bool gray, bool equalize, const std::vector<int> &codes){
+    // An equalized frame is gray too, the conversions then go through the table
+    this->chain.build(gray || equalize, codes);
+    this->equalize=equalize;
+}
+
+void ColorStage::apply(FrameContext &ctx){
+    if (this->equalize){
+        cv::Mat equalizedBuffer = ctx.borrow(CV_8U);
+        cv::equalizeHist(ctx.gray(), equalizedBuffer);
+        this->chain.applyToGray(equalizedBuffer, ctx.image);
+    }else
+        this->chain.apply(ctx.image);
+}
+
+/** Filters **/
+MorphologyStage::MorphologyStage(int operation, int size){
+    this->morphology.setOperation(operation);
+    this->morphology.setSize(size, size);
+}
+
+void MorphologyStage::apply(FrameContext &ctx){
+    this->morphology.apply(ctx.image, ctx.image);
+}
+
+BlurStage::BlurStage(double param){
+    this->filter.setBox(50*param/100+1);
+}
+
+void BlurStage::apply(FrameContext &ctx){
+    // The stripes read their neighbours' rows, so filter from a copy
+    cv::Mat source = ctx.borrow(ctx.image.type());
+    ctx.image.copyTo(source);
+    this->filter.apply(source, ctx.image);
+}
+
+SharpStage::SharpStage(double param){
+    int size = param;
+    if (size%2==0) size++;
+    this->filter.setUnsharp(size, 75);
+}
+
+void SharpStage::apply(FrameContext &ctx){
+    cv::Mat source = ctx.borrow(ctx.image.type());
+    ctx.image.copyTo(source);
+    this->filter.apply(source, ctx.image);
+}
+
+SobelStage::SobelStage(double param){
+    this->size=0;
+    if (param<33) this->size=3;
+    else if (param<66) this->size=5;
+    else if (param<100) this->size=7;
+}
+
+void SobelStage::apply(FrameContext &ctx){
+    cv::Sobel(ctx.image, ctx.image, ctx.image.depth(), 1, 1, this->size);
+}
+
+LaplacianStage::LaplacianStage(double param){
+    this->size = 31*param/100;
+    if (this->size%2==0) this->size++;
+}
+
+void LaplacianStage::apply(FrameContext &ctx){
+    cv::Laplacian(ctx.image, ctx.image, ctx.image.depth(), this->size);
+}
+
+CannyStage::CannyStage(double param1, double param2){
+    this->param1=param1;
+    this->param2=param2;
+}
+
+void CannyStage::apply(FrameContext &ctx){
+    cv::cvtColor(ctx.edges(this->param1, this->param2), ctx.image, CV_GRAY2BGR);
+    ctx.pinEdges();
+}
+
+HoughLinesStage::HoughLinesStage(double cannyParam1, double cannyParam2, double houghParam, bool tracking){
+    this->cannyParam1=cannyParam1;
+    this->cannyParam2=cannyParam2;
+    this->detector.setThreshold(houghParam+1);
+    this->detector.setSegments(30, 5);
+    this->detector.setTracking(tracking);
+}
+
+void HoughLinesStage::apply(FrameContext &ctx){
+    const std::vector<cv::Vec4i> &lines = this->detector.detect(ctx.edges(this->cannyParam1, this->cannyParam2),
+                                                                 ctx.frameNumber);
+    for (unsigned int i=0; i<lines.size();i++){
+        cv::Vec4i li = lines[i];
+        cv::line(ctx.image, cv::Point(li[0],li[1]),
+                 cv::Point(li[2],li[3]), cv::Scalar(255,255,0),
+                 3, CV_AA);
+    }
+}
+
+HoughCirclesStage::HoughCirclesStage(double cannyParam1, double cannyParam2, double houghParam,
+                                     int minRadius, int maxRadius, int pyramidLevel, bool tracking){
+    // Same meaning as the HoughCircles call it replaces: Canny high threshold,
+    // accumulator threshold and distance between centres
+    this->cannyParam1=cannyParam1+1;
+    this->pyramidLevel=pyramidLevel;
+    double scale = 1<<pyramidLevel;
+    this->detector.setVotes(cannyParam2+1);
+    this->detector.setMinDistance((houghParam+1)/scale);
+    this->detector.setRadiusRange(cvFloor(minRadius/scale), cvCeil(maxRadius/scale));
+    this->detector.setTracking(tracking);
+}
+
+void HoughCirclesStage::apply(FrameContext &ctx){
+    double low = std::max(1.0, this->cannyParam1/2), high = this->cannyParam1;
+    const std::vector<cv::Vec3f> *circles;
+    if (this->pyramidLevel==0){
+        // The frame gradients are shared with the other stages and give the edges too
+        this->canny.apply(ctx.gradientX(), ctx.gradientY(), low, high, this->levelEdges);
+        circles = &this->detector.detect(this->levelEdges, ctx.gradientX(), ctx.gradientY(), ctx.frameNumber);
+    }else{
+        cv::pyrDown(ctx.gray(), this->levelGray);
+        for (int i=1; i<this->pyramidLevel; i++)
+            cv::pyrDown(this->levelGray, this->levelGray);
+        cv::Sobel(this->levelGray, this->levelDx, CV_16S, 1, 0, 3);
+        cv::Sobel(this->levelGray, this->levelDy, CV_16S, 0, 1, 3);
+        this->canny.apply(this->levelDx, this->levelDy, low, high, this->levelEdges);
+        circles = &this->detector.detect(this->levelEdges, this->levelDx, this->levelDy, ctx.frameNumber);
+    }
+
+    float scale = 1<<this->pyramidLevel;
+    for (unsigned int i=0; i<circles->size();i++){
+        const cv::Vec3f &circle = (*circles)[i];
+        cv::Point cen(cvRound(circle[0]*scale),cvRound(circle[1]*scale));
+        int rad = cvRound(circle[2]*scale);
+        cv::circle( ctx.image, cen, 3, cv::Scalar(0,0,255), -1, 8, 0 );
+        cv::circle( ctx.image, cen, rad, cv::Scalar(255,0,0), 3, 8, 0 );
+    }
+}
+
+/** Analysis **/
+ConnectedObjectsStage::ConnectedObjectsStage(double threshold){
+    this->threshold=threshold;
+}
+
+void ConnectedObjectsStage::apply(FrameContext &ctx){
+    const ContourList &contours = ctx.contours(this->threshold);
+    cv::cvtColor(ctx.binary(this->threshold), ctx.image, CV_GRAY2BGR);
+    cv::drawContours(ctx.image, contours, -1/*Draw all contours*/, cv::Scalar(255,255,255),10);
+}
+
+ContoursStage::ContoursStage(double threshold){
+    this->threshold=threshold;
+}
+
+void ContoursStage::apply(FrameContext &ctx){
+    const ContourList &contours = ctx.contours(this->threshold);
+    cv::drawContours(ctx.image, contours, -1/*Draw all contours*/, cv::Scalar(255,255,0),2);
+}
+
+ShapeStage::ShapeStage(ShapeType shape, double threshold){
+    this->shape=shape;
+    this->threshold=threshold;
+}
+
+void ShapeStage::apply(FrameContext &ctx){
+    const std::vector<Component> &components = ctx.components(this->threshold, this->shape!=SHAPE_BOX);
+
+    for (unsigned int i=0; i<components.size(); i++){
+        const Component &component = components[i];
+        if (this->shape==SHAPE_BOX)
+            cv::rectangle(ctx.image, component.box, cv::Scalar(0,0,255),3);
+        else if (this->shape==SHAPE_CIRCLE)
+            cv::circle(ctx.image, component.center, component.radius, cv::Scalar(0,0,255),3);
+        else
+            cv::circle(ctx.image, component.center, 3, cv::Scalar(0,0,255),3);
+    }
+}
+
+/** Features **/
+MserStage::MserStage(const cv::Ptr<cv::MSER> &mserDet){
+    this->mserDet=mserDet;
+}
+
+void MserStage::apply(FrameContext &ctx){
+    keys.clear();
+    (*this->mserDet)(ctx.gray(), keys, cv::Mat());
+    cv::drawContours(ctx.image, keys, -1/*Draw all contours*/, cv::Scalar(255,0,0),2);
+}
+
+HarrisStage::HarrisStage(double featureParam){
+    this->detector.setBlockSize(100);
+    this->detector.setK(0.04 /*Harris parameter*/);
+    this->detector.setThreshold((int)(255*featureParam/100));
+}
+
+void HarrisStage::apply(FrameContext &ctx){
+    const std::vector<cv::Point> &corners = this->detector.detect(ctx.gradientX(), ctx.gradientY());
+    if (ctx.image.type()==CV_8UC3)
+        HarrisDetector::drawCorners(ctx.image, corners, cv::Scalar(255,255,0));
+    else
+        for (unsigned int i=0; i<corners.size(); i++)
+            cv::circle(ctx.image, corners[i], 1, cv::Scalar(255,255,0), 1);
+}
+
+HarrisNmsStage::HarrisNmsStage(double featureParam){
+    this->quality = featureParam/100+0.05;
+}
+
+void HarrisNmsStage::apply(FrameContext &ctx){
+    strongCorners.clear();
+    cv::goodFeaturesToTrack(ctx.gray(), strongCorners, 100, this->quality, 7, cv::noArray(), 3, true, 0.04);
+    for (unsigned int i=0; i<strongCorners.size(); i++){
+        cv::circle( ctx.image, strongCorners[i], 3,  cv::Scalar(255,0,255), 2);
+    }
+}
+
+KeypointStage::KeypointStage(const cv::Ptr<cv::FeatureDetector> &detector, const cv::Scalar &color, const char *name){
+    this->detector=detector;
+    this->color=color;
+    this->stageName=name;
+}
+
+void KeypointStage::apply(FrameContext &ctx){
+    keys.clear();
+    this->detector->detect(ctx.gray(), keys);
+    cv::drawKeypoints(ctx.image, keys, ctx.image, this->color, cv::DrawMatchesFlags::DRAW_OVER_OUTIMG);
+}
+
+FastStage::FastStage(double featureParam){
+    this->threshold = 100*featureParam/255;
+}
+
+void FastStage::apply(FrameContext &ctx){
+    keys.clear();
+    cv::FAST(ctx.gray(), keys, this->threshold, true);
+    cv::drawKeypoints(ctx.image, keys, ctx.image, cv::Scalar(255,0,0), cv::DrawMatchesFlags::DRAW_OVER_OUTIMG);
+}
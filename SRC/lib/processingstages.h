@@ -0,0 +1,296 @@
+/*
+    @file: processingstages.h
+    @license: GNU General Public License
+    @author: Juan Manuel Perez Rua
+    @note: Code written for th practical module of
+    Visual Perception at the Université de Bourgogne
+*/
+
+#ifndef PROCESSINGSTAGES_H
+#define PROCESSINGSTAGES_H
+
+#include <string>
+#include <vector>
+#include "opencv2/opencv.hpp"
+#include "opencv2/features2d/features2d.hpp"
+#include "opencv2/nonfree/features2d.hpp"
+#include "pipelineconfig.h"
+#include "framebufferpool.h"
+#include "logocompositor.h"
+#include "noisegenerator.h"
+#include "colorchain.h"
+#include "framefilter.h"
+#include "rectmorphology.h"
+#include "componentlabeller.h"
+#include "linedetector.h"
+#include "circledetector.h"
+#include "gradientcanny.h"
+#include "harrisdetector.h"
+
+typedef std::vector< std::vector<cv::Point> > ContourList;
+
+// Data handed from one stage to the next while a frame goes through the
+// pipeline. Planes derived from image (gray, thresholded binary, external
+// contours, connected components, Canny edges, Sobel gradients of the
+// gray plane) are computed on first use
+// and shared by every stage that asks for them until invalidate() is
+// called, which the pipeline does after each stage that modifies the image
+// (drawing an overlay does not count). pinEdges() lets the edges survive
+// the next invalidate(), for the stage that displays them.
+struct FrameContext{
+    FrameContext();
+    cv::Mat borrow(int type);
+    const cv::Mat &gray();
+    const cv::Mat &binary(double threshold);
+    const ContourList &contours(double threshold);
+    const std::vector<Component> &components(double threshold, bool circles);
+    const cv::Mat &edges(double low, double high);
+    void pinEdges();
+    const cv::Mat &gradientX();
+    const cv::Mat &gradientY();
+    void invalidate();
+    const cv::Mat *source;  // frame as captured, never modified
+    cv::Mat image;          // frame being processed
+    FrameBufferPool *pool;  // scratch buffers for the stages, see borrow()
+    quint64 frameNumber;    // capture sequence, seeds per-frame randomness
+private:
+    bool grayValid;
+    double binaryThreshold;   // <0 when binaryPlane is stale
+    double contoursThreshold; // <0 when contourList is stale
+    double componentsThreshold; // <0 when labeller is stale
+    bool componentCircles;
+    bool edgesValid, edgesPinned;
+    double edgesLow, edgesHigh;
+    bool gradientsValid;
+    void computeGradients();
+    cv::Mat grayPlane, binaryPlane, edgePlane, dxPlane, dyPlane;
+    ContourList contourList;
+    ComponentLabeller labeller;
+};
+
+// One block of the processing chain. Stages are built with all their
+// parameters already resolved and borrow their intermediate buffers from
+// the context pool, so apply() only does the image work.
+class ProcessingStage{
+public:
+    virtual ~ProcessingStage(){}
+    virtual const char *name() const = 0;
+    virtual void apply(FrameContext &ctx) = 0;
+    // false for stages that only draw results over the image
+    virtual bool modifiesImage() const { return true; }
+};
+
+/** Preprocessing **/
+class LogoStage : public ProcessingStage{
+public:
+    LogoStage(const cv::Mat &logo, double x, double y, int transparency);
+    const char *name() const { return "logo"; }
+    void apply(FrameContext &ctx);
+private:
+    LogoCompositor compositor;
+};
+
+class SaltPepperNoiseStage : public ProcessingStage{
+public:
+    SaltPepperNoiseStage(int power, unsigned int seed);
+    const char *name() const { return "saltpepper"; }
+    void apply(FrameContext &ctx);
+private:
+    NoiseGenerator generator;
+    int power;
+};
+
+class GaussianNoiseStage : public ProcessingStage{
+public:
+    GaussianNoiseStage(int power, int stddev, unsigned int seed);
+    const char *name() const { return "gaussian"; }
+    void apply(FrameContext &ctx);
+private:
+    NoiseGenerator generator;
+    int power;
+    int stddev;
+};
+
+// Gray conversion, histogram equalization and the colorspace conversions
+// in one stage, see ColorChain
+class ColorStage : public ProcessingStage{
+public:
+    ColorStage(bool gray, bool equalize, const std::vector<int> &codes);
+    const char *name() const { return "color"; }
+    void apply(FrameContext &ctx);
+private:
+    ColorChain chain;
+    bool equalize;
+};
+
+/** Filters **/
+class MorphologyStage : public ProcessingStage{
+public:
+    MorphologyStage(int operation, int size);
+    const char *name() const { return "morphology"; }
+    void apply(FrameContext &ctx);
+private:
+    RectMorphology morphology;
+};
+
+class BlurStage : public ProcessingStage{
+public:
+    BlurStage(double param);
+    const char *name() const { return "blur"; }
+    void apply(FrameContext &ctx);
+private:
+    FrameFilter filter;
+};
+
+class SharpStage : public ProcessingStage{
+public:
+    SharpStage(double param);
+    const char *name() const { return "sharp"; }
+    void apply(FrameContext &ctx);
+private:
+    FrameFilter filter;
+};
+
+class SobelStage : public ProcessingStage{
+public:
+    SobelStage(double param);
+    const char *name() const { return "sobel"; }
+    void apply(FrameContext &ctx);
+private:
+    int size;
+};
+
+class LaplacianStage : public ProcessingStage{
+public:
+    LaplacianStage(double param);
+    const char *name() const { return "laplacian"; }
+    void apply(FrameContext &ctx);
+private:
+    int size;
+};
+
+class CannyStage : public ProcessingStage{
+public:
+    CannyStage(double param1, double param2);
+    const char *name() const { return "canny"; }
+    void apply(FrameContext &ctx);
+private:
+    double param1, param2;
+};
+
+class HoughLinesStage : public ProcessingStage{
+public:
+    HoughLinesStage(double cannyParam1, double cannyParam2, double houghParam, bool tracking);
+    const char *name() const { return "houghlines"; }
+    void apply(FrameContext &ctx);
+    bool modifiesImage() const { return false; }
+private:
+    double cannyParam1, cannyParam2;
+    LineDetector detector;
+};
+
+class HoughCirclesStage : public ProcessingStage{
+public:
+    HoughCirclesStage(double cannyParam1, double cannyParam2, double houghParam,
+                      int minRadius, int maxRadius, int pyramidLevel, bool tracking);
+    const char *name() const { return "houghcircles"; }
+    void apply(FrameContext &ctx);
+    bool modifiesImage() const { return false; }
+private:
+    double cannyParam1;
+    int pyramidLevel;
+    CircleDetector detector;
+    GradientCanny canny;    // edges from the same gradients the detector votes with
+    cv::Mat levelEdges;
+    cv::Mat levelGray, levelDx, levelDy; // pyramidLevel>0 only
+};
+
+/** Analysis **/
+class ConnectedObjectsStage : public ProcessingStage{
+public:
+    ConnectedObjectsStage(double threshold);
+    const char *name() const { return "conobjs"; }
+    void apply(FrameContext &ctx);
+private:
+    double threshold;
+};
+
+class ContoursStage : public ProcessingStage{
+public:
+    ContoursStage(double threshold);
+    const char *name() const { return "contours"; }
+    void apply(FrameContext &ctx);
+    bool modifiesImage() const { return false; }
+private:
+    double threshold;
+};
+
+class ShapeStage : public ProcessingStage{
+public:
+    ShapeStage(ShapeType shape, double threshold);
+    const char *name() const { return "shape"; }
+    void apply(FrameContext &ctx);
+    bool modifiesImage() const { return false; }
+private:
+    ShapeType shape;
+    double threshold;
+};
+
+/** Features **/
+class MserStage : public ProcessingStage{
+public:
+    MserStage(const cv::Ptr<cv::MSER> &mserDet);
+    const char *name() const { return "mser"; }
+    void apply(FrameContext &ctx);
+    bool modifiesImage() const { return false; }
+private:
+    cv::Ptr<cv::MSER> mserDet;
+    std::vector< std::vector<cv::Point> > keys;
+};
+
+class HarrisStage : public ProcessingStage{
+public:
+    HarrisStage(double featureParam);
+    const char *name() const { return "harris"; }
+    void apply(FrameContext &ctx);
+    bool modifiesImage() const { return false; }
+private:
+    HarrisDetector detector;
+};
+
+class HarrisNmsStage : public ProcessingStage{
+public:
+    HarrisNmsStage(double featureParam);
+    const char *name() const { return "harrisnms"; }
+    void apply(FrameContext &ctx);
+    bool modifiesImage() const { return false; }
+private:
+    double quality;
+    std::vector<cv::Point> strongCorners;
+};
+
+class KeypointStage : public ProcessingStage{
+public:
+    KeypointStage(const cv::Ptr<cv::FeatureDetector> &detector, const cv::Scalar &color, const char *name);
+    const char *name() const { return this->stageName; }
+    void apply(FrameContext &ctx);
+    bool modifiesImage() const { return false; }
+private:
+    cv::Ptr<cv::FeatureDetector> detector;
+    cv::Scalar color;
+    const char *stageName;
+    std::vector<cv::KeyPoint> keys;
+};
+
+class FastStage : public ProcessingStage{
+public:
+    FastStage(double featureParam);
+    const char *name() const { return "fast"; }
+    void apply(FrameContext &ctx);
+    bool modifiesImage() const { return false; }
+private:
+    int threshold;
+    std::vector<cv::KeyPoint> keys;
+};
+
+#endif // PROCESSINGSTAGES_H
@@ -0,0 +1,191 @@
+/*
+    @file: rectmorphology.cpp
+    @license: GNU General Public License
+    @author: Juan Manuel Perez Rua
+    @note: Code written for th practical module of
+    Visual Perception at the Université de Bourgogne
+*/
+
+#include "rectmorphology.h"
+#include <algorithm>
+#include <cstring>
+#if CV_SSE2
+#include <emmintrin.h>
+#endif
+
+struct MaxOp{
+    static uchar apply(uchar a, uchar b){ return std::max(a, b); }
+#if CV_SSE2
+    static __m128i apply(__m128i a, __m128i b){ return _mm_max_epu8(a, b); }
+#endif
+};
+
+struct MinOp{
+    static uchar apply(uchar a, uchar b){ return std::min(a, b); }
+#if CV_SSE2
+    static __m128i apply(__m128i a, __m128i b){ return _mm_min_epu8(a, b); }
+#endif
+};
+
+/* dst[i] = Op(a[i], b[i]) for n bytes */
+template <typename Op>
+static void combineRows(const uchar *a, const uchar *b, uchar *dst, int n){
+    int i=0;
+#if CV_SSE2
+    for (; i<=n-16; i+=16)
+        _mm_storeu_si128((__m128i*)(dst+i), Op::apply(_mm_loadu_si128((const __m128i*)(a+i)),
+                                                      _mm_loadu_si128((const __m128i*)(b+i))));
+#endif
+    for (; i<n; i++)
+        dst[i] = Op::apply(a[i], b[i]);
+}
+
+/* Window [x-anchor, x-anchor+k) along one row of n pixels with cn interleaved channels */
+template <typename Op>
+static void filterRow(const uchar *src, uchar *dst, uchar *forward, uchar *backward, int n, int cn, int k){
+    int anchor = k/2;
+    for (int c=0; c<cn; c++){
+        for (int x=0; x<n; x++){
+            int i = x*cn+c;
+            forward[i] = (x%k==0) ? src[i] : Op::apply(forward[i-cn], src[i]);
+        }
+        for (int x=n-1; x>=0; x--){
+            int i = x*cn+c;
+            backward[i] = (x==n-1 || (x+1)%k==0) ? src[i] : Op::apply(backward[i+cn], src[i]);
+        }
+        for (int x=0; x<n; x++){
+            int lo = x-anchor, hi = std::min(n-1, x-anchor+k-1);
+            // A window clipped on either side lies inside a single block
+            if (lo<0)
+                dst[x*cn+c] = forward[hi*cn+c];
+            else if (lo/k==hi/k)
+                dst[x*cn+c] = backward[lo*cn+c];
+            else
+                dst[x*cn+c] = Op::apply(backward[lo*cn+c], forward[hi*cn+c]);
+        }
+    }
+}
+
+template <typename Op>
+class HorizontalBody : public cv::ParallelLoopBody{
+public:
+    HorizontalBody(const cv::Mat &src, cv::Mat &dst, int k) : src(src), dst(dst), k(k){}
+    void operator()(const cv::Range &rows) const{
+        int n = this->src.cols*this->src.channels();
+        std::vector<uchar> forward(n), backward(n);
+        for (int r=rows.start; r<rows.end; r++)
+            filterRow<Op>(this->src.ptr<uchar>(r), this->dst.ptr<uchar>(r), &forward[0], &backward[0],
+                          this->src.cols, this->src.channels(), this->k);
+    }
+private:
+    const cv::Mat &src;
+    cv::Mat &dst;
+    int k;
+};
+
+// Same scheme as filterRow with rows as samples, on the byte columns [start,end)
+template <typename Op>
+class VerticalBody : public cv::ParallelLoopBody{
+public:
+    VerticalBody(const cv::Mat &src, cv::Mat &dst, cv::Mat &forward, cv::Mat &backward, int k, int chunk)
+        : src(src), dst(dst), forward(forward), backward(backward), k(k), chunk(chunk){}
+    void operator()(const cv::Range &chunks) const{
+        int width = this->src.cols*this->src.channels();
+        int start = chunks.start*this->chunk, end = std::min(width, chunks.end*this->chunk);
+        int n = end-start, rows = this->src.rows, anchor = this->k/2;
+        for (int y=0; y<rows; y++){
+            if (y%this->k==0)
+                memcpy(this->forward.ptr<uchar>(y)+start, this->src.ptr<uchar>(y)+start, n);
+            else
+                combineRows<Op>(this->forward.ptr<uchar>(y-1)+start, this->src.ptr<uchar>(y)+start,
+                                this->forward.ptr<uchar>(y)+start, n);
+        }
+        for (int y=rows-1; y>=0; y--){
+            if (y==rows-1 || (y+1)%this->k==0)
+                memcpy(this->backward.ptr<uchar>(y)+start, this->src.ptr<uchar>(y)+start, n);
+            else
+                combineRows<Op>(this->backward.ptr<uchar>(y+1)+start, this->src.ptr<uchar>(y)+start,
+                                this->backward.ptr<uchar>(y)+start, n);
+        }
+        for (int y=0; y<rows; y++){
+            int lo = y-anchor, hi = std::min(rows-1, y-anchor+this->k-1);
+            if (lo<0)
+                memcpy(this->dst.ptr<uchar>(y)+start, this->forward.ptr<uchar>(hi)+start, n);
+            else if (lo/this->k==hi/this->k)
+                memcpy(this->dst.ptr<uchar>(y)+start, this->backward.ptr<uchar>(lo)+start, n);
+            else
+                combineRows<Op>(this->backward.ptr<uchar>(lo)+start, this->forward.ptr<uchar>(hi)+start,
+                                this->dst.ptr<uchar>(y)+start, n);
+        }
+    }
+private:
+    const cv::Mat &src;
+    cv::Mat &dst;
+    cv::Mat &forward, &backward;
+    int k, chunk;
+};
+
+RectMorphology::RectMorphology(){
+    this->operation=cv::MORPH_DILATE;
+    setSize(3, 3);
+}
+
+void RectMorphology::setOperation(int operation){
+    this->operation=operation;
+}
+
+void RectMorphology::setSize(int width, int height){
+    this->size = cv::Size(std::max(1, width), std::max(1, height));
+    this->kernel = cv::Mat(this->size, CV_8U, cv::Scalar(1));
+}
+
+// src and dst may be the same image
+void RectMorphology::apply(const cv::Mat &src, cv::Mat &dst){
+    if (src.depth()!=CV_8U || src.empty()){
+        cv::morphologyEx(src, dst, this->operation, this->kernel);
+        return;
+    }
+    switch (this->operation){
+    case cv::MORPH_DILATE:
+        filter(src, dst, true);
+        break;
+    case cv::MORPH_ERODE:
+        filter(src, dst, false);
+        break;
+    case cv::MORPH_OPEN:
+        filter(src, dst, false);
+        filter(dst, dst, true);
+        break;
+    case cv::MORPH_CLOSE:
+        filter(src, dst, true);
+        filter(dst, dst, false);
+        break;
+    default:
+        cv::morphologyEx(src, dst, this->operation, this->kernel);
+    }
+}
+
+void RectMorphology::filter(const cv::Mat &src, cv::Mat &dst, bool dilate){
+    this->horizontal.create(src.size(), src.type());
+    if (this->size.width>1){
+        cv::Range rows(0, src.rows);
+        if (dilate)
+            cv::parallel_for_(rows, HorizontalBody<MaxOp>(src, this->horizontal, this->size.width));
+        else
+            cv::parallel_for_(rows, HorizontalBody<MinOp>(src, this->horizontal, this->size.width));
+    }else
+        src.copyTo(this->horizontal);
+
+    dst.create(src.size(), src.type());
+    if (this->size.height>1){
+        this->forward.create(src.size(), src.type());
+        this->backward.create(src.size(), src.type());
+        int width = src.cols*src.channels(), chunk = 256;
+        cv::Range chunks(0, (width+chunk-1)/chunk);
+        if (dilate)
+            cv::parallel_for_(chunks, VerticalBody<MaxOp>(this->horizontal, dst, this->forward, this->backward, this->size.height, chunk));
+        else
+            cv::parallel_for_(chunks, VerticalBody<MinOp>(this->horizontal, dst, this->forward, this->backward, this->size.height, chunk));
+    }else
+        this->horizontal.copyTo(dst);
+}
@@ -0,0 +1,39 @@
+/*
+    @file: rectmorphology.h
+    @license: GNU General Public License
+    @author: Juan Manuel Perez Rua
+    @note: Code written for th practical module of
+    Visual Perception at the Université de Bourgogne
+*/
+
+#ifndef RECTMORPHOLOGY_H
+#define RECTMORPHOLOGY_H
+
+#include <vector>
+#include "opencv2/opencv.hpp"
+
+// Dilate, erode, open and close with a rectangular structuring element
+// anchored at its centre, at a constant cost per pixel whatever its size
+// (van Herk / Gil-Werman): the element is split in a horizontal and a
+// vertical segment, and for each one a running max (min) restarted every
+// k samples is computed forwards and backwards; any window of k samples is
+// then the max of one backward and one forward value. The vertical pass
+// works on whole rows at a time, 16 bytes per instruction with SSE2.
+// Pixels outside the frame are ignored, like OpenCV's default border.
+// Only 8-bit frames take this path; anything else goes to cv::morphologyEx.
+class RectMorphology{
+public:
+    RectMorphology();
+    void setOperation(int operation); // cv::MORPH_DILATE, ERODE, OPEN or CLOSE
+    void setSize(int width, int height);
+    void apply(const cv::Mat &src, cv::Mat &dst);
+private:
+    void filter(const cv::Mat &src, cv::Mat &dst, bool dilate);
+    int operation;
+    cv::Size size;
+    cv::Mat kernel;     // only for the cv::morphologyEx fallback
+    cv::Mat horizontal; // output of the horizontal pass
+    cv::Mat forward, backward; // vertical running max/min, one row per image row
+};
+
+#endif // RECTMORPHOLOGY_H
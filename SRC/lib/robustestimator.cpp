@@ -0,0 +1,416 @@
+/*
+    @file: robustestimator.cpp
+    @license: GNU General Public License
+    @author: Juan Manuel Perez Rua
+    @note: Code written for th practical module of
+    Visual Perception at the Université de Bourgogne
+*/
+
+#include "robustestimator.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+/* Largest squared distance of the pair to its two epipolar lines (as OpenCV) */
+static inline double epipolarError(const double *F, const cv::Point2f &m1, const cv::Point2f &m2){
+    double a = F[0]*m1.x + F[1]*m1.y + F[2];
+    double b = F[3]*m1.x + F[4]*m1.y + F[5];
+    double c = F[6]*m1.x + F[7]*m1.y + F[8];
+    double s2 = 1./(a*a + b*b);
+    double d2 = m2.x*a + m2.y*b + c;
+    a = F[0]*m2.x + F[3]*m2.y + F[6];
+    b = F[1]*m2.x + F[4]*m2.y + F[7];
+    c = F[2]*m2.x + F[5]*m2.y + F[8];
+    double s1 = 1./(a*a + b*b);
+    double d1 = m1.x*a + m1.y*b + c;
+    return std::max(d1*d1*s1, d2*d2*s2);
+}
+
+/* Similarity taking the centroid to the origin and the mean distance to sqrt(2) */
+static void normalization(const std::vector<cv::Point2f> &points, double *T){
+    double cx=0, cy=0, d=0;
+    for (unsigned int i=0; i<points.size(); i++){
+        cx += points[i].x;
+        cy += points[i].y;
+    }
+    cx /= points.size();
+    cy /= points.size();
+    for (unsigned int i=0; i<points.size(); i++)
+        d += std::sqrt((points[i].x-cx)*(points[i].x-cx) + (points[i].y-cy)*(points[i].y-cy));
+    double s = d>0 ? std::sqrt(2.0)*points.size()/d : 1;
+    double t[9] = { s, 0, -s*cx,  0, s, -s*cy,  0, 0, 1 };
+    memcpy(T, t, sizeof(t));
+}
+
+struct QualityLess{
+    QualityLess(const std::vector<float> &quality) : quality(quality){}
+    bool operator()(int a, int b) const { return this->quality[a] < this->quality[b]; }
+    const std::vector<float> &quality;
+};
+
+RobustEstimator::RobustEstimator(){
+    this->threshold=3.0;
+    this->confidence=0.99;
+    this->maxIterations=2000; // what findFundamentalMat allows RANSAC
+    this->iterations=0;
+    this->rejected=0;
+    this->progressive=false;
+    this->poolSize=0;
+    this->poolSamples=0;
+    this->poolDeadline=0;
+}
+
+// Max distance to the epipolar lines, in pixels
+void RobustEstimator::setThreshold(double threshold){
+    this->threshold=threshold;
+}
+
+void RobustEstimator::setConfidence(double confidence){
+    this->confidence=confidence;
+}
+
+void RobustEstimator::setMaxIterations(int iterations){
+    this->maxIterations=std::max(1, iterations);
+}
+
+// Samples drawn by the last findFundamental()
+int RobustEstimator::getIterations() const{
+    return this->iterations;
+}
+
+// Hypotheses the SPRT dropped before scoring every point
+int RobustEstimator::getRejected() const{
+    return this->rejected;
+}
+
+/* SAMPLE distinct correspondences. With PROSAC, sample t takes the newest
+   point of the pool plus SAMPLE-1 older ones until the pool has had its
+   share of samples, and the pool grows by one point at each deadline */
+void RobustEstimator::sample(int t, int *indices){
+    int n = this->pixels1.size();
+    int pool = n, fixed = 0;
+    if (this->progressive && this->poolSize<n){
+        if (t>=this->poolDeadline){
+            double next = this->poolSamples*(this->poolSize+1)/(this->poolSize+1-SAMPLE);
+            this->poolDeadline += std::ceil(next-this->poolSamples);
+            this->poolSamples = next;
+            this->poolSize++;
+        }
+        pool = this->poolSize;
+        if (this->poolDeadline>=t){
+            indices[SAMPLE-1] = pool-1;
+            pool--;
+            fixed = 1;
+        }
+    }
+    for (int i=0; i<SAMPLE-fixed; i++){
+        bool repeated;
+        do{
+            indices[i] = this->rng.uniform(0, pool);
+            repeated = false;
+            for (int j=0; j<i; j++)
+                repeated = repeated || indices[j]==indices[i];
+        }while (repeated);
+    }
+}
+
+/* 7-point algorithm on normalized coordinates: the null space of the
+   constraints is a pencil of matrices, det(F)=0 gives a cubic in its
+   parameter. Up to 3 models, returned in pixel coordinates */
+int RobustEstimator::solveMinimal(const int *indices, double models[3][9]){
+    double a[SAMPLE*9];
+    for (int i=0; i<SAMPLE; i++){
+        const cv::Point2d &m1 = this->unit1[indices[i]];
+        const cv::Point2d &m2 = this->unit2[indices[i]];
+        double row[9] = { m2.x*m1.x, m2.x*m1.y, m2.x, m2.y*m1.x, m2.y*m1.y, m2.y, m1.x, m1.y, 1 };
+        memcpy(a+9*i, row, sizeof(row));
+    }
+    cv::Mat A(SAMPLE, 9, CV_64F, a), w, u, vt;
+    cv::SVD::compute(A, w, u, vt, cv::SVD::FULL_UV);
+    double f1[9], f2[9];
+    for (int i=0; i<9; i++){
+        f1[i] = vt.at<double>(7,i) - vt.at<double>(8,i);
+        f2[i] = vt.at<double>(8,i);
+    }
+
+    // det(lambda*f1 + f2) = c[0]*lambda^3 + c[1]*lambda^2 + c[2]*lambda + c[3]
+    double c[4], t0, t1, t2;
+    t0 = f2[4]*f2[8] - f2[5]*f2[7];
+    t1 = f2[3]*f2[8] - f2[5]*f2[6];
+    t2 = f2[3]*f2[7] - f2[4]*f2[6];
+    c[3] = f2[0]*t0 - f2[1]*t1 + f2[2]*t2;
+    c[2] = f1[0]*t0 - f1[1]*t1 + f1[2]*t2 -
+           f1[3]*(f2[1]*f2[8] - f2[2]*f2[7]) +
+           f1[4]*(f2[0]*f2[8] - f2[2]*f2[6]) -
+           f1[5]*(f2[0]*f2[7] - f2[1]*f2[6]) +
+           f1[6]*(f2[1]*f2[5] - f2[2]*f2[4]) -
+           f1[7]*(f2[0]*f2[5] - f2[2]*f2[3]) +
+           f1[8]*(f2[0]*f2[4] - f2[1]*f2[3]);
+    t0 = f1[4]*f1[8] - f1[5]*f1[7];
+    t1 = f1[3]*f1[8] - f1[5]*f1[6];
+    t2 = f1[3]*f1[7] - f1[4]*f1[6];
+    c[1] = f2[0]*t0 - f2[1]*t1 + f2[2]*t2 -
+           f2[3]*(f1[1]*f1[8] - f1[2]*f1[7]) +
+           f2[4]*(f1[0]*f1[8] - f1[2]*f1[6]) -
+           f2[5]*(f1[0]*f1[7] - f1[1]*f1[6]) +
+           f2[6]*(f1[1]*f1[5] - f1[2]*f1[4]) -
+           f2[7]*(f1[0]*f1[5] - f1[2]*f1[3]) +
+           f2[8]*(f1[0]*f1[4] - f1[1]*f1[3]);
+    c[0] = f1[0]*t0 - f1[1]*t1 + f1[2]*t2;
+
+    cv::Mat coeffs(1, 4, CV_64F, c), roots;
+    int count = cv::solveCubic(coeffs, roots);
+    int solutions=0;
+    for (int k=0; k<count; k++){
+        double lambda = roots.at<double>(k);
+        double fn[9];
+        for (int i=0; i<9; i++)
+            fn[i] = f1[i]*lambda + f2[i];
+        // F = T2' * fn * T1
+        double m[9];
+        for (int r=0; r<3; r++)
+            for (int col=0; col<3; col++)
+                m[3*r+col] = fn[3*r]*this->T1[col] + fn[3*r+1]*this->T1[3+col] + fn[3*r+2]*this->T1[6+col];
+        double *F = models[solutions];
+        double norm = 0;
+        for (int r=0; r<3; r++)
+            for (int col=0; col<3; col++){
+                F[3*r+col] = this->T2[r]*m[col] + this->T2[3+r]*m[3+col] + this->T2[6+r]*m[6+col];
+                norm += F[3*r+col]*F[3*r+col];
+            }
+        if (norm<=DBL_EPSILON)
+            continue;
+        norm = 1/std::sqrt(norm);
+        for (int i=0; i<9; i++)
+            F[i] *= norm;
+        solutions++;
+    }
+    return solutions;
+}
+
+/* SPRT: walk the points in random order updating the likelihood ratio of
+   "bad model" against "good model"; false as soon as it passes A */
+bool RobustEstimator::evaluate(const double *F, double A, double epsilon, double delta, int &support, int &tested){
+    double threshold2 = this->threshold*this->threshold;
+    double inlierRatio = delta/epsilon, outlierRatio = (1-delta)/(1-epsilon);
+    double lambda = 1;
+    int n = this->evaluationOrder.size();
+    support = 0;
+    for (int j=0; j<n; j++){
+        int i = this->evaluationOrder[j];
+        if (epipolarError(F, this->pixels1[i], this->pixels2[i])<=threshold2){
+            support++;
+            lambda *= inlierRatio;
+        }else{
+            lambda *= outlierRatio;
+            if (lambda>A){
+                tested = j+1;
+                return false;
+            }
+        }
+    }
+    tested = n;
+    return true;
+}
+
+/* Inliers of F at threshold2, marked in mask (quality order) when given */
+int RobustEstimator::support(const double *F, double threshold2, std::vector<uchar> *mask){
+    int n = this->pixels1.size(), count = 0;
+    if (mask!=NULL)
+        mask->resize(n);
+    for (int i=0; i<n; i++){
+        bool inlier = epipolarError(F, this->pixels1[i], this->pixels2[i])<=threshold2;
+        count += inlier;
+        if (mask!=NULL)
+            (*mask)[i] = inlier;
+    }
+    return count;
+}
+
+/* Least squares F of the masked correspondences */
+bool RobustEstimator::eightPoint(const std::vector<uchar> &mask, double *F){
+    std::vector<cv::Point2f> points1, points2;
+    for (unsigned int i=0; i<mask.size(); i++){
+        if (mask[i]){
+            points1.push_back(this->pixels1[i]);
+            points2.push_back(this->pixels2[i]);
+        }
+    }
+    if (points1.size()<8)
+        return false;
+    cv::Mat fit = cv::findFundamentalMat(cv::Mat(points1), cv::Mat(points2), CV_FM_8POINT);
+    if (fit.rows!=3 || fit.cols!=3 || cv::countNonZero(fit)==0)
+        return false;
+    for (int i=0; i<9; i++)
+        F[i] = fit.at<double>(i/3, i%3);
+    return true;
+}
+
+/* LO-RANSAC: refit on the inliers at LO_STEPS..1 times the threshold,
+   keeping every refit that does not lose support */
+void RobustEstimator::localOptimize(double *F, int &bestSupport){
+    std::vector<uchar> mask;
+    double threshold2 = this->threshold*this->threshold;
+    for (int step=LO_STEPS; step>=1; step--){
+        double wide = this->threshold*step;
+        support(F, wide*wide, &mask);
+        double fit[9];
+        if (!eightPoint(mask, fit))
+            continue;
+        int count = support(fit, threshold2, NULL);
+        if (count>=bestSupport){
+            memcpy(F, fit, sizeof(fit));
+            bestSupport = count;
+        }
+    }
+}
+
+/* Decision threshold A of the SPRT (Matas and Chum): the root of
+   A = K + 1 + log(A), with K the cost of a model in point evaluations
+   (about 200 for the 7-point solver, 2.38 models per sample on average)
+   times the information the test gains per point. No test when a bad
+   model looks as good as a good one */
+double RobustEstimator::sprtThreshold(double epsilon, double delta){
+    if (delta>=epsilon || epsilon>=1)
+        return DBL_MAX;
+    double C = (1-delta)*std::log((1-delta)/(1-epsilon)) + delta*std::log(delta/epsilon);
+    double K = 200*C/2.38;
+    double A = K+1;
+    for (int i=0; i<10; i++)
+        A = K+1+std::log(A);
+    return A;
+}
+
+/* Samples needed to draw an all-inlier sample, whose model then survives
+   the SPRT with probability 1-1/A, at the requested confidence */
+int RobustEstimator::iterationsFor(double epsilon, double A) const{
+    double p = std::pow(epsilon, (double)SAMPLE);
+    if (A<DBL_MAX)
+        p *= 1-1/A;
+    if (p<=DBL_EPSILON)
+        return this->maxIterations;
+    if (p>=1)
+        return 1;
+    double k = std::log(1-this->confidence)/std::log(1-p);
+    return k>=this->maxIterations ? this->maxIterations : std::max(1, (int)std::ceil(k));
+}
+
+/* PROSAC maximality: the best matches usually hold a much larger share of
+   inliers than the whole set. For every prefix of n matches that samples
+   have so far been drawn from only, the iterations needed at its inlier
+   ratio; prefixes whose inlier count could be chance (under the normal
+   approximation of a binomial with success rate delta) do not count */
+int RobustEstimator::progressiveLimit(const double *F, double delta, double A){
+    std::vector<uchar> mask;
+    support(F, this->threshold*this->threshold, &mask);
+    int limit = this->maxIterations, count = 0;
+    for (unsigned int i=0; i<mask.size(); i++){
+        count += mask[i];
+        double n = i+1;
+        if ((int)n<this->poolSize || count<=delta*n + SAMPLE + 3*std::sqrt(n*delta*(1-delta)))
+            continue;
+        limit = std::min(limit, iterationsFor(count/n, A));
+    }
+    return limit;
+}
+
+/* quality (optional, one per correspondence, lower is better) enables PROSAC */
+cv::Mat RobustEstimator::findFundamental(const std::vector<cv::Point2f> &points1, const std::vector<cv::Point2f> &points2,
+                                         std::vector<uchar> &inliers, const std::vector<float> &quality){
+    int n = points1.size();
+    this->iterations=0;
+    this->rejected=0;
+    inliers.assign(n, 0);
+    if (n<8 || points2.size()!=points1.size()){
+        // Nothing to sample from: same answer as before
+        if (n<SAMPLE || points2.size()!=points1.size())
+            return cv::Mat::zeros(3, 3, CV_64F);
+        return cv::findFundamentalMat(cv::Mat(points1), cv::Mat(points2), CV_FM_RANSAC,
+                                      this->threshold, this->confidence, inliers);
+    }
+
+    std::vector<int> order(n);
+    for (int i=0; i<n; i++)
+        order[i]=i;
+    // Equal qualities carry no ordering
+    this->progressive = (int)quality.size()==n
+            && *std::min_element(quality.begin(), quality.end()) < *std::max_element(quality.begin(), quality.end());
+    if (this->progressive)
+        std::stable_sort(order.begin(), order.end(), QualityLess(quality));
+    this->pixels1.resize(n);
+    this->pixels2.resize(n);
+    for (int i=0; i<n; i++){
+        this->pixels1[i] = points1[order[i]];
+        this->pixels2[i] = points2[order[i]];
+    }
+    normalization(this->pixels1, this->T1);
+    normalization(this->pixels2, this->T2);
+    this->unit1.resize(n);
+    this->unit2.resize(n);
+    for (int i=0; i<n; i++){
+        this->unit1[i] = cv::Point2d(this->T1[0]*this->pixels1[i].x + this->T1[2], this->T1[4]*this->pixels1[i].y + this->T1[5]);
+        this->unit2[i] = cv::Point2d(this->T2[0]*this->pixels2[i].x + this->T2[2], this->T2[4]*this->pixels2[i].y + this->T2[5]);
+    }
+
+    // Same samples for the same input
+    this->rng = cv::RNG(0x5EED);
+    this->evaluationOrder.resize(n);
+    for (int i=0; i<n; i++)
+        this->evaluationOrder[i]=i;
+    for (int i=n-1; i>0; i--)
+        std::swap(this->evaluationOrder[i], this->evaluationOrder[this->rng.uniform(0, i+1)]);
+
+    // PROSAC: of maxIterations samples from all n, this many would come from the best SAMPLE
+    this->poolSize = SAMPLE;
+    this->poolSamples = this->maxIterations;
+    for (int i=0; i<SAMPLE; i++)
+        this->poolSamples *= (double)(SAMPLE-i)/(n-i);
+    this->poolDeadline = 1;
+
+    double epsilon = 0.1, delta = 0.01; // pessimistic starting guesses
+    double A = sprtThreshold(epsilon, delta);
+    double testedRejected = 0, inliersRejected = 0;
+    int limit = this->maxIterations;
+    double best[9];
+    int bestSupport = 0;
+    int indices[SAMPLE];
+    double models[3][9];
+    for (int t=1; t<=limit; t++){
+        this->iterations = t;
+        sample(t, indices);
+        int count = solveMinimal(indices, models);
+        for (int k=0; k<count; k++){
+            int found, tested;
+            if (!evaluate(models[k], A, epsilon, delta, found, tested)){
+                // Bad models tell how often a point agrees with one by chance
+                this->rejected++;
+                testedRejected += tested;
+                inliersRejected += found;
+                delta = std::max(0.001, inliersRejected/testedRejected);
+                A = sprtThreshold(epsilon, delta);
+                continue;
+            }
+            if (found>bestSupport){
+                memcpy(best, models[k], sizeof(best));
+                bestSupport = found;
+                localOptimize(best, bestSupport);
+                epsilon = (double)bestSupport/n;
+                A = sprtThreshold(epsilon, delta);
+                limit = std::min(limit, iterationsFor(epsilon, A));
+                // A single all-inlier sample fits the noise of its 7 points:
+                // let a few compete even when the best matches are all inliers
+                if (this->progressive)
+                    limit = std::min(limit, std::max((int)MIN_PROGRESSIVE, progressiveLimit(best, delta, A)));
+            }
+        }
+    }
+    if (bestSupport==0)
+        return cv::Mat::zeros(3, 3, CV_64F);
+
+    std::vector<uchar> mask;
+    support(best, this->threshold*this->threshold, &mask);
+    for (int i=0; i<n; i++)
+        inliers[order[i]] = mask[i];
+    return cv::Mat(3, 3, CV_64F, best).clone();
+}
@@ -0,0 +1,65 @@
+/*
+    @file: robustestimator.h
+    @license: GNU General Public License
+    @author: Juan Manuel Perez Rua
+    @note: Code written for th practical module of
+    Visual Perception at the Université de Bourgogne
+*/
+
+#ifndef ROBUSTESTIMATOR_H
+#define ROBUSTESTIMATOR_H
+
+#include <vector>
+#include "opencv2/opencv.hpp"
+
+// Fundamental matrix from noisy correspondences, a drop-in for
+// findFundamentalMat(..., FM_RANSAC, threshold, confidence, mask):
+// - PROSAC: with a quality per correspondence (match distance, lower is
+//   better) samples are drawn from the best ones first and the pool grows
+//   progressively, so good matches are found in a few dozen iterations.
+// - SPRT: a hypothesis is checked against the points in random order and
+//   dropped as soon as a sequential likelihood test says it is bad, which
+//   on low inlier ratios saves most of the scoring.
+// - LO-RANSAC: every new best model is refitted with the 8-point algorithm
+//   on its inliers at a shrinking threshold.
+// The error and the iteration cap are the ones of OpenCV, so thresholds
+// keep their meaning: largest squared distance to the two epipolar lines.
+class RobustEstimator{
+public:
+    RobustEstimator();
+    void setThreshold(double threshold);
+    void setConfidence(double confidence);
+    void setMaxIterations(int iterations);
+    cv::Mat findFundamental(const std::vector<cv::Point2f> &points1, const std::vector<cv::Point2f> &points2,
+                            std::vector<uchar> &inliers, const std::vector<float> &quality=std::vector<float>());
+    int getIterations() const;
+    int getRejected() const;
+private:
+    enum { SAMPLE=7, LO_STEPS=4, MIN_PROGRESSIVE=50 };
+    void sample(int t, int *indices);
+    int solveMinimal(const int *indices, double models[3][9]);
+    bool evaluate(const double *F, double A, double epsilon, double delta, int &support, int &tested);
+    int support(const double *F, double threshold2, std::vector<uchar> *mask);
+    bool eightPoint(const std::vector<uchar> &mask, double *F);
+    void localOptimize(double *F, int &bestSupport);
+    int progressiveLimit(const double *F, double delta, double A);
+    static double sprtThreshold(double epsilon, double delta);
+    int iterationsFor(double epsilon, double A) const;
+    double threshold;
+    double confidence;
+    int maxIterations;
+    int iterations;
+    int rejected;
+    cv::RNG rng;
+    // Correspondences in quality order, in pixels and normalized
+    std::vector<cv::Point2f> pixels1, pixels2;
+    std::vector<cv::Point2d> unit1, unit2;
+    double T1[9], T2[9];
+    std::vector<int> evaluationOrder;
+    // PROSAC schedule
+    bool progressive;
+    int poolSize;
+    double poolSamples, poolDeadline;
+};
+
+#endif // ROBUSTESTIMATOR_H
@@ -7,6 +7,41 @@
 */
 
 #include "robustmatcher.h"
+#include <algorithm>
+#include <cstring>
+
+// Detection and extraction of the images that missed the cache, one per task
+class ExtractBody : public cv::ParallelLoopBody{
+public:
+    ExtractBody(RobustMatcher *matcher, cv::Mat **images, RobustMatcher::ImageFeatures **features)
+        : matcher(matcher), images(images), features(features){}
+    void operator()(const cv::Range &range) const{
+        for (int i=range.start; i<range.end; i++)
+            this->matcher->extract(*this->images[i], *this->features[i]);
+    }
+private:
+    RobustMatcher *matcher;
+    cv::Mat **images;
+    RobustMatcher::ImageFeatures **features;
+};
+
+// One block of query rows searched in a trained index
+struct KnnTask{
+    cv::DescriptorMatcher *index;
+    cv::Mat query;
+    std::vector< std::vector<cv::DMatch> > matches;
+};
+
+class KnnBody : public cv::ParallelLoopBody{
+public:
+    KnnBody(std::vector<KnnTask> &tasks) : tasks(tasks){}
+    void operator()(const cv::Range &range) const{
+        for (int i=range.start; i<range.end; i++)
+            this->tasks[i].index->knnMatch(this->tasks[i].query, this->tasks[i].matches, 2);
+    }
+private:
+    std::vector<KnnTask> &tasks;
+};
 
 RobustMatcher::RobustMatcher(){
     this->ratio=0.65f;
@@ -14,6 +49,15 @@ RobustMatcher::RobustMatcher(){
     this->confidence=0.99f;
     this->distance=3.0;
     this->methodFM=CV_FM_RANSAC;
+    this->useCounter=0;
+    this->cacheHits=0;
+    this->pairHash1=0;
+    this->pairHash2=0;
+    this->pairRatio=-1;
+    this->parallel=true;
+    this->matcherType=MATCHER_FLANN;
+    // match() holds references to two entries while filling them
+    this->cache.reserve(CACHE_SIZE);
 
     // SURF is the default feature
     detector= new cv::SurfFeatureDetector();
@@ -23,11 +67,13 @@ RobustMatcher::RobustMatcher(){
 // Set the feature detector
 void RobustMatcher::setFeatureDetector(cv::Ptr<cv::FeatureDetector>& detect){
     detector= detect;
+    clearCache();
 }
 
 // Set the descriptor extractor
 void RobustMatcher::setDescriptorExtractor(cv::Ptr<cv::DescriptorExtractor>& desc){
     extractor= desc;
+    clearCache();
 }
 
 // Set confidence
@@ -44,6 +90,143 @@ void RobustMatcher::setMethod(int m){
     methodFM = m;
 }
 
+// Serial mode runs every step on the calling thread
+void RobustMatcher::setParallel(bool p){
+    this->parallel=p;
+}
+
+// Has to suit the descriptors of the extractor
+void RobustMatcher::setMatcherType(MatcherType type){
+    if (type!=this->matcherType)
+        clearCache();
+    this->matcherType=type;
+}
+
+void RobustMatcher::clearCache(){
+    this->cache.clear();
+    this->pairRatio=-1;
+    this->pairMatches.clear();
+}
+
+// Images whose features came from the cache
+int RobustMatcher::getCacheHits() const{
+    return this->cacheHits;
+}
+
+/* FNV-1a over the pixels, size and type */
+uint64 RobustMatcher::imageHash(const cv::Mat &image){
+    uint64 hash = 14695981039346656037ULL;
+    const uint64 prime = 1099511628211ULL;
+    hash = (hash ^ (uint64)image.rows) * prime;
+    hash = (hash ^ (uint64)image.cols) * prime;
+    hash = (hash ^ (uint64)image.type()) * prime;
+    size_t rowBytes = image.cols*image.elemSize();
+    for (int r=0; r<image.rows; r++){
+        const uchar *row = image.ptr<uchar>(r);
+        size_t i=0;
+        for (; i+8<=rowBytes; i+=8){
+            uint64 word;
+            memcpy(&word, row+i, 8);
+            hash = (hash ^ word) * prime;
+        }
+        for (; i<rowBytes; i++)
+            hash = (hash ^ row[i]) * prime;
+    }
+    return hash;
+}
+
+/* Cache entry for hash; a new one (replacing the least recently used
+   entry once the cache is full) has found false and still has to be filled */
+RobustMatcher::ImageFeatures &RobustMatcher::slot(uint64 hash, bool &found){
+    this->useCounter++;
+    for (unsigned int i=0; i<this->cache.size(); i++){
+        if (this->cache[i].hash==hash){
+            this->cache[i].lastUse=this->useCounter;
+            this->cacheHits++;
+            found=true;
+            return this->cache[i];
+        }
+    }
+    found=false;
+    unsigned int oldest = this->cache.size();
+    if (oldest<CACHE_SIZE)
+        this->cache.push_back(ImageFeatures());
+    else{
+        oldest=0;
+        for (unsigned int i=1; i<this->cache.size(); i++)
+            if (this->cache[i].lastUse<this->cache[oldest].lastUse)
+                oldest=i;
+        this->cache[oldest]=ImageFeatures();
+    }
+    ImageFeatures &f = this->cache[oldest];
+    f.hash=hash;
+    f.lastUse=this->useCounter;
+    return f;
+}
+
+/* Detect, extract and index the features of image into f */
+void RobustMatcher::extract(cv::Mat &image, ImageFeatures &f){
+    detector->detect(image,f.keypoints);
+    extractor->compute(image,f.keypoints,f.descriptors);
+    if (!f.descriptors.empty()){
+        if (this->matcherType==MATCHER_FLANN)
+            f.index = new cv::FlannBasedMatcher();
+        else if (f.descriptors.rows<LSH_MIN_ROWS)
+            f.index = new HammingMatcher();
+        else // 12 tables of 20 bit keys, probing neighbouring buckets up to 2 bits away
+            f.index = new cv::FlannBasedMatcher(new cv::flann::LshIndexParams(12, 20, 2));
+        f.index->add(std::vector<cv::Mat>(1, f.descriptors));
+        f.index->train();
+    }
+}
+
+/* 2-NN of image 1 descriptors in image 2 (matches1) and the other way round.
+   Each direction is cut into blocks of KNN_BLOCK_ROWS queries or more, one
+   per thread at most; the blocks are searched concurrently and joined back
+   in query order, so the result is the same as two whole knnMatch calls */
+void RobustMatcher::knnBoth(ImageFeatures &features1, ImageFeatures &features2,
+                            std::vector< std::vector<cv::DMatch> > &matches1,
+                            std::vector< std::vector<cv::DMatch> > &matches2){
+    ImageFeatures *query[2] = { &features1, &features2 };
+    ImageFeatures *train[2] = { &features2, &features1 };
+    std::vector< std::vector<cv::DMatch> > *out[2] = { &matches1, &matches2 };
+    std::vector<KnnTask> tasks;
+    std::vector<int> firstTask(3, 0);
+    for (int d=0; d<2; d++){
+        firstTask[d] = tasks.size();
+        const cv::Mat &descriptors = query[d]->descriptors;
+        if (train[d]->index.empty() || descriptors.empty())
+            continue;
+        int blocks = 1;
+        if (this->parallel)
+            blocks = std::max(1, std::min(cv::getNumThreads(), descriptors.rows/KNN_BLOCK_ROWS));
+        for (int b=0; b<blocks; b++){
+            KnnTask task;
+            task.index = train[d]->index;
+            task.query = descriptors.rowRange(b*descriptors.rows/blocks, (b+1)*descriptors.rows/blocks);
+            tasks.push_back(task);
+        }
+    }
+    firstTask[2] = tasks.size();
+    if (this->parallel)
+        cv::parallel_for_(cv::Range(0, tasks.size()), KnnBody(tasks));
+    else
+        KnnBody(tasks)(cv::Range(0, tasks.size()));
+
+    for (int d=0; d<2; d++){
+        out[d]->clear();
+        for (int t=firstTask[d]; t<firstTask[d+1]; t++){
+            // Query indices are relative to the block
+            int offset = out[d]->size();
+            std::vector< std::vector<cv::DMatch> > &block = tasks[t].matches;
+            for (unsigned int q=0; q<block.size(); q++)
+                for (unsigned int k=0; k<block[q].size(); k++)
+                    block[q][k].queryIdx += offset;
+            out[d]->insert(out[d]->end(), block.begin(), block.end());
+        }
+    }
+}
+
 // Main method:
 cv::Mat RobustMatcher::match(cv::Mat &image1,
                              cv::Mat &image2,
@@ -51,44 +234,42 @@ cv::Mat RobustMatcher::match(cv::Mat &image1,
                              std::vector<cv::KeyPoint> &keypoints1,
                              std::vector<cv::KeyPoint> &keypoints2){
 
-    // 1a. Detection of the SURF features
-    detector->detect(image1,keypoints1);
-    detector->detect(image2,keypoints2);
-    // 1b. Extraction of the SURF descriptors
-    cv::Mat descriptors1, descriptors2;
-    extractor->compute(image1,keypoints1,descriptors1);
-    extractor->compute(image2,keypoints2,descriptors2);
-    // 2. Match the two image descriptors
-    // Construction of the matcher
-    //cv::BruteForceMatcher< cv::L2<float> > matcher;
-    cv::FlannBasedMatcher matcher;
-
-    // from image 1 to image 2
-    // based on k nearest neighbours (with k=2)
-    std::vector< std::vector<cv::DMatch> > matches1;
-    matcher.knnMatch(descriptors1,descriptors2,
-                     matches1, // vector of matches (up to 2 per entry)
-                     2);
-     // return 2 nearest neighbours
-     // from image 2 to image 1
-     // based on k nearest neighbours (with k=2)
-     std::vector< std::vector<cv::DMatch> > matches2;
-     matcher.knnMatch(descriptors2,descriptors1,
-     matches2, // vector of matches (up to 2 per entry)
-     2);
-     // return 2 nearest neighbours
-     // 3. Remove matches for which NN ratio is
-     // > than threshold
-     // clean image 1 -> image 2 matches
-     int removed= ratioTest(matches1);
-     // clean image 2 -> image 1 matches
-     removed= ratioTest(matches2);
-     // 4. Remove non-symmetrical matches
-     std::vector<cv::DMatch> symMatches;
-
-     symmetryTest(matches1,matches2,symMatches);
+    // 1. Detection and extraction of the SURF features,
+    // with a FLANN index over each image's descriptors (cached)
+    bool found1, found2;
+    ImageFeatures &features1 = slot(imageHash(image1), found1);
+    ImageFeatures &features2 = slot(imageHash(image2), found2);
+    if (&features1==&features2)
+        found2=true; // same content: extracted once
+    cv::Mat *images[2];
+    ImageFeatures *missing[2];
+    int misses=0;
+    if (!found1){ images[misses]=&image1; missing[misses++]=&features1; }
+    if (!found2){ images[misses]=&image2; missing[misses++]=&features2; }
+    if (this->parallel && misses==2)
+        cv::parallel_for_(cv::Range(0, misses), ExtractBody(this, images, missing));
+    else
+        ExtractBody(this, images, missing)(cv::Range(0, misses));
+    keypoints1 = features1.keypoints;
+    keypoints2 = features2.keypoints;
+    matches.clear();
+
+    if (features1.hash!=this->pairHash1 || features2.hash!=this->pairHash2 || ratio!=this->pairRatio){
+        // 2. Match the two image descriptors
+        // both ways, based on k nearest neighbours (with k=2)
+        std::vector< std::vector<cv::DMatch> > matches1, matches2;
+        knnBoth(features1, features2, matches1, matches2);
+        // 3. Remove matches for which NN ratio is
+        // > than threshold, and
+        // 4. non-symmetrical matches, in one pass
+        this->pairMatches.clear();
+        symmetricRatioTest(matches1,matches2,this->pairMatches);
+        this->pairHash1=features1.hash;
+        this->pairHash2=features2.hash;
+        this->pairRatio=ratio;
+    }
      // 5. Validate matches using RANSAC
-     cv::Mat fundemental= ransacTest(symMatches,
+     cv::Mat fundemental= ransacTest(this->pairMatches,
      keypoints1, keypoints2, matches);
      // return the found fundemental matrix
      return fundemental;
@@ -117,35 +298,56 @@ int RobustMatcher::ratioTest(std::vector< std::vector<cv::DMatch> >&matches){
     return removed;
 }
 
+// Same test as ratioTest, without clearing anything
+static bool passesRatio(const std::vector<cv::DMatch> &knn, float ratio){
+    return knn.size() > 1 && !(knn[0].distance/knn[1].distance > ratio);
+}
+
+// Best image 1 match of every surviving image 2 -> image 1 entry, by query index.
+// knnMatch gives one entry per query; should a query repeat, its first entry counts
+void RobustMatcher::indexReverse(const std::vector< std::vector<cv::DMatch> >& matches2, bool applyRatio){
+    int size=0;
+    for (unsigned int i=0; i<matches2.size(); i++)
+        if (!matches2[i].empty())
+            size = std::max(size, matches2[i][0].queryIdx+1);
+    this->reverse.assign(size, -1);
+    for (unsigned int i=0; i<matches2.size(); i++){
+        const std::vector<cv::DMatch> &knn = matches2[i];
+        bool kept = applyRatio ? passesRatio(knn, ratio) : knn.size() >= 2;
+        if (kept && this->reverse[knn[0].queryIdx] < 0)
+            this->reverse[knn[0].queryIdx] = knn[0].trainIdx;
+    }
+}
+
+// Image 1 -> image 2 matches whose image 2 keypoint points straight back
+void RobustMatcher::collectSymmetric(const std::vector< std::vector<cv::DMatch> >& matches1, bool applyRatio,
+                                     std::vector< cv::DMatch >& symMatches){
+    int size = this->reverse.size();
+    for (unsigned int i=0; i<matches1.size(); i++){
+        const std::vector<cv::DMatch> &knn = matches1[i];
+        if (applyRatio ? !passesRatio(knn, ratio) : knn.size() < 2)
+            continue;
+        int train = knn[0].trainIdx;
+        if (train < size && this->reverse[train] == knn[0].queryIdx)
+            symMatches.push_back(cv::DMatch(knn[0].queryIdx, train, knn[0].distance));
+    }
+}
+
 // Insert symmetrical matches in symMatches vector
+// (entries cleared by ratioTest are ignored). Linear: the reverse matches
+// are looked up by index instead of scanned for every match
 void RobustMatcher::symmetryTest(const std::vector< std::vector<cv::DMatch> >& matches1,const std::vector< std::vector<cv::DMatch> >& matches2,
                   std::vector< cv::DMatch >& symMatches) {
-    // for all matches image 1 -> image 2
-    for (std::vector< std::vector<cv::DMatch> >::const_iterator matchIterator1= matches1.begin();
-                                                                matchIterator1!= matches1.end(); ++matchIterator1) {
-        // ignore deleted matches
-        if (matchIterator1->size() < 2)
-        continue;
-        // for all matches image 2 -> image 1
-        for (std::vector< std::vector<cv::DMatch> >::const_iterator matchIterator2= matches2.begin();matchIterator2!= matches2.end();
-                                                                ++matchIterator2) {
-            // ignore deleted matches
-            if (matchIterator2->size() < 2)
-            continue;
-            // Match symmetry test
-            if ((*matchIterator1)[0].queryIdx ==
-            (*matchIterator2)[0].trainIdx &&
-            (*matchIterator2)[0].queryIdx ==
-            (*matchIterator1)[0].trainIdx) {
-                // add symmetrical match
-                symMatches.push_back(
-                cv::DMatch((*matchIterator1)[0].queryIdx,
-                (*matchIterator1)[0].trainIdx,
-                (*matchIterator1)[0].distance));
-                break; // next match in image 1 -> image 2
-            }
-        }
-    }
+    indexReverse(matches2, false);
+    collectSymmetric(matches1, false, symMatches);
+}
+
+// ratioTest on both directions followed by symmetryTest, without modifying
+// the match lists and without a pass of its own for the ratio
+void RobustMatcher::symmetricRatioTest(const std::vector< std::vector<cv::DMatch> >& matches1,const std::vector< std::vector<cv::DMatch> >& matches2,
+                                       std::vector< cv::DMatch >& symMatches) {
+    indexReverse(matches2, true);
+    collectSymmetric(matches1, true, symMatches);
 }
 
 // Identify good matches using RANSAC
@@ -163,10 +365,19 @@ cv::Mat RobustMatcher::ransacTest(const std::vector<cv::DMatch>& matches,const s
         y= keypoints2[it->trainIdx].pt.y;
         points2.push_back(cv::Point2f(x,y));
     }
-    // Compute F matrix using RANSAC
+    // Compute F matrix using RANSAC (PROSAC on the match distances)
     std::vector<uchar> inliers(points1.size(),0);
 
-    cv::Mat fundemental= cv::findFundamentalMat(cv::Mat(points1),cv::Mat(points2), inliers, methodFM,distance,confidence); // confidence probability
+    cv::Mat fundemental;
+    if (methodFM==CV_FM_RANSAC){
+        std::vector<float> quality(matches.size());
+        for (unsigned int i=0; i<matches.size(); i++)
+            quality[i] = matches[i].distance;
+        estimator.setThreshold(distance);
+        estimator.setConfidence(confidence);
+        fundemental= estimator.findFundamental(points1, points2, inliers, quality);
+    }else
+        fundemental= cv::findFundamentalMat(cv::Mat(points1),cv::Mat(points2), inliers, methodFM,distance,confidence); // confidence probability
     // extract the surviving (inliers) matches
     std::vector<uchar>::const_iterator
     itIn= inliers.begin();
@@ -178,7 +389,7 @@ cv::Mat RobustMatcher::ransacTest(const std::vector<cv::DMatch>& matches,const s
             outMatches.push_back(*itM);
         }
     }
-    if (refineF) {
+    if (refineF && outMatches.size()>=8) {
         // The F matrix will be recomputed with
         // all accepted matches
         // Convert keypoints into Point2f
@@ -13,7 +13,23 @@
 #include "opencv2/nonfree/features2d.hpp"
 #include "opencv2/calib3d/calib3d.hpp"
 #include "opencv2/opencv.hpp"
+#include "hammingmatcher.h"
+#include "robustestimator.h"
 
+enum MatcherType{
+    MATCHER_FLANN,   // float descriptors (SURF, SIFT), FLANN kd-trees
+    MATCHER_HAMMING  // binary descriptors (ORB, BRISK), brute force or LSH for large sets
+};
+
+// Keypoints, descriptors and the trained FLANN index of the last few images
+// are cached by content hash, together with the ratio and symmetry tested
+// matches of the last pair, so matching the same views again (another F
+// method, say) only repeats the final estimation. In parallel mode (the
+// default) the two images are detected concurrently and both 2-NN
+// directions are searched at once, split into blocks of query rows; the
+// matches are the same as in serial mode. Binary descriptors are matched
+// with MATCHER_HAMMING: a popcount brute force matcher, or a multi-probe
+// LSH index for images with more than LSH_MIN_ROWS descriptors.
 class RobustMatcher{
 
 public:
@@ -24,6 +40,10 @@ public:
     void setMinDistanceToEpipolar(double val);
     void setRatio(double v);
     void setMethod(int m);
+    void setParallel(bool p);
+    void setMatcherType(MatcherType type);
+    void clearCache();
+    int getCacheHits() const;
     cv::Mat match(cv::Mat &image1, cv::Mat &image2,
                   std::vector<cv::DMatch> &matches,
                   std::vector<cv::KeyPoint> &keypoints1,
@@ -31,6 +51,8 @@ public:
     int ratioTest(std::vector< std::vector<cv::DMatch> >&matches);
     void symmetryTest(const std::vector< std::vector<cv::DMatch> >& matches1,const std::vector< std::vector<cv::DMatch> >& matches2,
                       std::vector< cv::DMatch >& symMatches);
+    void symmetricRatioTest(const std::vector< std::vector<cv::DMatch> >& matches1,const std::vector< std::vector<cv::DMatch> >& matches2,
+                            std::vector< cv::DMatch >& symMatches);
     cv::Mat ransacTest(const std::vector<cv::DMatch>& matches,
                                       const std::vector<cv::KeyPoint>& keypoints1,
                                       const std::vector<cv::KeyPoint>& keypoints2,
@@ -45,7 +67,38 @@ private:
     bool refineF; // if true will refine the F matrix
     double distance; // min distance to epipolar
     double confidence; // confidence level (probability)
+    RobustEstimator estimator; // F for CV_FM_RANSAC
     int methodFM;
+    friend class ExtractBody;
+    friend class KnnBody;
+    enum { CACHE_SIZE=4, KNN_BLOCK_ROWS=512, LSH_MIN_ROWS=4096 };
+    struct ImageFeatures{
+        uint64 hash;
+        int lastUse;
+        std::vector<cv::KeyPoint> keypoints;
+        cv::Mat descriptors;
+        cv::Ptr<cv::DescriptorMatcher> index; // trained on descriptors, empty if there are none
+    };
+    static uint64 imageHash(const cv::Mat &image);
+    ImageFeatures &slot(uint64 hash, bool &found);
+    void extract(cv::Mat &image, ImageFeatures &f);
+    void knnBoth(ImageFeatures &features1, ImageFeatures &features2,
+                 std::vector< std::vector<cv::DMatch> > &matches1,
+                 std::vector< std::vector<cv::DMatch> > &matches2);
+    bool parallel;
+    MatcherType matcherType;
+    std::vector<ImageFeatures> cache;
+    int useCounter;
+    int cacheHits;
+    // Symmetric matches of the last pair, valid for this ratio
+    uint64 pairHash1, pairHash2;
+    float pairRatio;
+    std::vector<cv::DMatch> pairMatches;
+    // image 2 keypoint -> its image 1 match, or -1 (symmetry tests)
+    std::vector<int> reverse;
+    void indexReverse(const std::vector< std::vector<cv::DMatch> >& matches2, bool applyRatio);
+    void collectSymmetric(const std::vector< std::vector<cv::DMatch> >& matches1, bool applyRatio,
+                          std::vector< cv::DMatch >& symMatches);
 };
 
 #endif // ROBUSTMATCHER_H
@@ -0,0 +1,160 @@
+/*
+    @file: stageprofiler.cpp
+    @license: GNU General Public License
+    @author: Juan Manuel Perez Rua
+    @note: Code written for th practical module of
+    Visual Perception at the Université de Bourgogne
+*/
+
+#include "stageprofiler.h"
+#include <cmath>
+#include <cstdio>
+
+const char *profileBlockName(ProfileBlock block){
+    switch (block){
+    case PROFILE_LOGO: return "logo";
+    case PROFILE_NOISE: return "noise";
+    case PROFILE_COLOR: return "color";
+    case PROFILE_MORPHOLOGY: return "morphology";
+    case PROFILE_FILTER: return "filter";
+    case PROFILE_CANNY: return "canny";
+    case PROFILE_HOUGH: return "hough";
+    case PROFILE_CONTOURS: return "contours";
+    case PROFILE_FEATURES: return "features";
+    case PROFILE_STEREO: return "stereo";
+    case PROFILE_CALIBRATION: return "calibration";
+    case PROFILE_STITCHING: return "stitching";
+    case PROFILE_HISTOGRAM: return "histogram";
+    case PROFILE_FRAME: return "frame";
+    default: return "?";
+    }
+}
+
+ProfileSummary::ProfileSummary(){
+    this->count=0;
+    this->p50=0;
+    this->p95=0;
+    this->p99=0;
+}
+
+/** LatencyHistogram **/
+LatencyHistogram::LatencyHistogram(){
+}
+
+// Bucket 0 holds everything under 1us, then BUCKETS_PER_OCTAVE per power of two
+int LatencyHistogram::bucketOf(double us){
+    if (us<1.0)
+        return 0;
+    int exponent;
+    double mantissa = std::frexp(us, &exponent); // us = mantissa*2^exponent, mantissa in [0.5,1)
+    int sub = (int)((mantissa*2.0-1.0)*BUCKETS_PER_OCTAVE);
+    int bucket = 1 + (exponent-1)*BUCKETS_PER_OCTAVE + sub;
+    return bucket<BUCKETS ? bucket : BUCKETS-1;
+}
+
+// Geometric centre of a bucket, in milliseconds
+double LatencyHistogram::bucketValue(int bucket){
+    if (bucket==0)
+        return 0.0005;
+    double low = std::pow(2.0, (bucket-1)/(double)BUCKETS_PER_OCTAVE);
+    double high = std::pow(2.0, bucket/(double)BUCKETS_PER_OCTAVE);
+    return std::sqrt(low*high)/1000.0;
+}
+
+void LatencyHistogram::add(double ms){
+    this->counts[bucketOf(ms*1000.0)].ref();
+    this->total.ref();
+}
+
+void LatencyHistogram::reset(){
+    for (int i=0; i<BUCKETS; i++)
+        this->counts[i].fetchAndStoreRelaxed(0);
+    this->total.fetchAndStoreRelaxed(0);
+}
+
+int LatencyHistogram::count() const{
+    return this->total;
+}
+
+// p in [0,1]. Counts may move while we read them, the result is still a
+// value some recent sample fell close to.
+double LatencyHistogram::percentile(double p) const{
+    int snapshot[BUCKETS];
+    int n=0;
+    for (int i=0; i<BUCKETS; i++){
+        snapshot[i] = this->counts[i];
+        n += snapshot[i];
+    }
+    if (n==0)
+        return 0;
+    int rank = (int)std::ceil(p*n);
+    if (rank<1) rank=1;
+    int seen=0;
+    for (int i=0; i<BUCKETS; i++){
+        seen += snapshot[i];
+        if (seen>=rank)
+            return bucketValue(i);
+    }
+    return bucketValue(BUCKETS-1);
+}
+
+/** StageProfiler **/
+StageProfiler::StageProfiler(){
+}
+
+void StageProfiler::record(ProfileBlock block, double ms){
+    this->histograms[block].add(ms);
+}
+
+ProfileSummary StageProfiler::summary(ProfileBlock block) const{
+    ProfileSummary s;
+    const LatencyHistogram &h = this->histograms[block];
+    s.count = h.count();
+    s.p50 = h.percentile(0.50);
+    s.p95 = h.percentile(0.95);
+    s.p99 = h.percentile(0.99);
+    return s;
+}
+
+void StageProfiler::reset(){
+    for (int i=0; i<PROFILE_COUNT; i++)
+        this->histograms[i].reset();
+}
+
+void StageProfiler::setOverlay(bool enabled){
+    this->overlay.fetchAndStoreRelaxed(enabled ? 1 : 0);
+}
+
+bool StageProfiler::overlayEnabled() const{
+    return this->overlay!=0;
+}
+
+// One line per block that has samples: name, p50/p95/p99 in ms.
+// Drawn outlined so it stays readable on gray and color frames.
+void StageProfiler::drawOverlay(cv::Mat &image) const{
+    if (image.empty())
+        return;
+    char line[128];
+    int y=15;
+    for (int i=0; i<PROFILE_COUNT; i++){
+        ProfileSummary s = summary((ProfileBlock)i);
+        if (s.count==0)
+            continue;
+        sprintf(line, "%-11s %7.2f %7.2f %7.2f ms", profileBlockName((ProfileBlock)i), s.p50, s.p95, s.p99);
+        cv::putText(image, line, cv::Point(5,y), CV_FONT_HERSHEY_PLAIN, 0.9, cv::Scalar::all(0), 3);
+        cv::putText(image, line, cv::Point(5,y), CV_FONT_HERSHEY_PLAIN, 0.9, cv::Scalar::all(255), 1);
+        y+=14;
+    }
+}
+
+/** ScopedTimer **/
+ScopedTimer::ScopedTimer(StageProfiler *profiler, ProfileBlock block){
+    this->profiler=profiler;
+    this->block=block;
+    this->start = profiler!=NULL ? cv::getTickCount() : 0;
+}
+
+ScopedTimer::~ScopedTimer(){
+    if (this->profiler!=NULL)
+        this->profiler->record(this->block, 1000.0*(double)(cv::getTickCount()-this->start)/cv::getTickFrequency());
+}
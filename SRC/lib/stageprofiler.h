@@ -0,0 +1,91 @@
+/*
+    @file: stageprofiler.h
+    @license: GNU General Public License
+    @author: Juan Manuel Perez Rua
+    @note: Code written for th practical module of
+    Visual Perception at the Université de Bourgogne
+*/
+
+#ifndef STAGEPROFILER_H
+#define STAGEPROFILER_H
+
+#include <QAtomicInt>
+#include "opencv2/opencv.hpp"
+
+// Blocks of computerVisionMachine that are timed separately
+enum ProfileBlock{
+    PROFILE_LOGO,
+    PROFILE_NOISE,
+    PROFILE_COLOR,
+    PROFILE_MORPHOLOGY,
+    PROFILE_FILTER,
+    PROFILE_CANNY,
+    PROFILE_HOUGH,
+    PROFILE_CONTOURS,
+    PROFILE_FEATURES,
+    PROFILE_STEREO,
+    PROFILE_CALIBRATION,
+    PROFILE_STITCHING,
+    PROFILE_HISTOGRAM,
+    PROFILE_FRAME,      // the whole per-frame processing
+    PROFILE_COUNT
+};
+
+const char *profileBlockName(ProfileBlock block);
+
+struct ProfileSummary{
+    ProfileSummary();
+    int count;
+    double p50; // milliseconds
+    double p95;
+    double p99;
+};
+
+// Latency histogram with logarithmic buckets (4 per octave of microseconds,
+// from 1us to ~70s). add() is a single atomic increment so any number of
+// threads can record into it; percentiles are read from the bucket counts
+// and are accurate to one bucket (about 19%).
+class LatencyHistogram{
+public:
+    enum{ BUCKETS_PER_OCTAVE=4, OCTAVES=26, BUCKETS=BUCKETS_PER_OCTAVE*OCTAVES+1 };
+    LatencyHistogram();
+    void add(double ms);
+    void reset();
+    int count() const;
+    double percentile(double p) const;
+private:
+    static int bucketOf(double us);
+    static double bucketValue(int bucket);
+    QAtomicInt counts[BUCKETS];
+    QAtomicInt total;
+    LatencyHistogram(const LatencyHistogram &);
+    LatencyHistogram &operator=(const LatencyHistogram &);
+};
+
+// One histogram per ProfileBlock, shared by every thread running stages
+class StageProfiler{
+public:
+    StageProfiler();
+    void record(ProfileBlock block, double ms);
+    ProfileSummary summary(ProfileBlock block) const;
+    void reset();
+    void setOverlay(bool enabled);
+    bool overlayEnabled() const;
+    void drawOverlay(cv::Mat &image) const;
+private:
+    LatencyHistogram histograms[PROFILE_COUNT];
+    QAtomicInt overlay;
+};
+
+// Times its own scope into a profiler block; a NULL profiler disables it
+class ScopedTimer{
+public:
+    ScopedTimer(StageProfiler *profiler, ProfileBlock block);
+    ~ScopedTimer();
+private:
+    StageProfiler *profiler;
+    ProfileBlock block;
+    int64 start;
+};
+
+#endif // STAGEPROFILER_H
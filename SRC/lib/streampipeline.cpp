@@ -0,0 +1,325 @@
+/*
+    @file: streampipeline.cpp
+    @license: GNU General Public License
+    @author: Juan Manuel Perez Rua
+    @note: Code written for th practical module of
+    Visual Perception at the Université de Bourgogne
+*/
+
+#include "streampipeline.h"
+#include "processingpipeline.h"
+
+static double ticksToMs(int64 from, int64 to){
+    return 1000.0*(double)(to-from)/cv::getTickFrequency();
+}
+
+FramePacket::FramePacket(){
+    this->sequence=0;
+    this->captureStart=0;
+    this->captureEnd=0;
+    this->processStart=0;
+    this->processEnd=0;
+    this->presentStart=0;
+}
+
+StageStats::StageStats(){
+    this->queueDepth=0;
+    this->queueCapacity=0;
+    this->dropped=0;
+    this->frames=0;
+    this->latencyMs=0;
+    this->waitMs=0;
+}
+
+StreamStats::StreamStats(){
+    this->workers=0;
+    this->frameAllocations=0;
+    this->streamAllocations=0;
+}
+
+StageMonitor::StageMonitor(){
+    reset();
+}
+
+void StageMonitor::add(double latencyMs, double waitMs){
+    QMutexLocker locker(&this->mutex);
+    if (this->frames==0){
+        this->latencyMs=latencyMs;
+        this->waitMs=waitMs;
+    }else{
+        this->latencyMs = 0.9*this->latencyMs + 0.1*latencyMs;
+        this->waitMs = 0.9*this->waitMs + 0.1*waitMs;
+    }
+    this->frames++;
+}
+
+void StageMonitor::reset(){
+    QMutexLocker locker(&this->mutex);
+    this->frames=0;
+    this->latencyMs=0;
+    this->waitMs=0;
+}
+
+void StageMonitor::fill(StageStats &stats){
+    QMutexLocker locker(&this->mutex);
+    stats.frames=this->frames;
+    stats.latencyMs=this->latencyMs;
+    stats.waitMs=this->waitMs;
+}
+
+/** Stage threads **/
+class CaptureThread : public QThread{
+public:
+    CaptureThread(StreamPipeline *stream){ this->stream=stream; }
+protected:
+    void run();
+private:
+    StreamPipeline *stream;
+};
+
+void CaptureThread::run(){
+    quint64 sequence=0;
+    int interval = stream->source->getFrameInterval();
+    cv::Size size;
+    int type=-1;
+    while (!stream->stopping){
+        FramePacket packet;
+        // Read into a recycled buffer of the size of the previous frame
+        if (type>=0 && size.area()>0)
+            packet.frame = stream->pool.acquire(size, type);
+        packet.captureStart = cv::getTickCount();
+        if (!stream->source->read(packet.frame)){
+            stream->sourceEnded.fetchAndStoreOrdered(1);
+            break;
+        }
+        packet.captureEnd = cv::getTickCount();
+        packet.sequence = ++sequence;
+        size = packet.frame.size();
+        type = packet.frame.type();
+        stream->captureMonitor.add(ticksToMs(packet.captureStart, packet.captureEnd), 0);
+        if (!stream->captureQueue->push(packet))
+            break;
+        if (interval>0)
+            msleep(interval);
+    }
+}
+
+class ProcessingWorker : public QThread{
+public:
+    ProcessingWorker(StreamPipeline *stream, int index){ this->stream=stream; this->index=index; }
+protected:
+    void run();
+private:
+    StreamPipeline *stream;
+    int index;
+};
+
+void ProcessingWorker::run(){
+    ProcessingPipeline pipeline;
+    PipelineConfig config;
+    int builtGeneration=-1;
+    FramePacket packet;
+
+    pipeline.setProfiler(stream->profiler);
+    while (!stream->stopping){
+        /* Each worker rebuilds its own stages when the GUI changed something */
+        if (stream->settings->generation()!=builtGeneration){
+            builtGeneration = stream->settings->snapshot(config);
+            pipeline.build(config);
+        }
+        /* Hough tracking needs the frames in sequence: only the first worker runs */
+        if (config.houghTracking && this->index>0){
+            if (stream->sourceEnded && stream->captureQueue->size()==0)
+                break;
+            msleep(50);
+            continue;
+        }
+        if (!stream->captureQueue->pop(packet, 50)){
+            if (stream->sourceEnded && stream->captureQueue->size()==0)
+                break;
+            continue;
+        }
+        packet.processStart = cv::getTickCount();
+        cv::Mat &output = pipeline.run(packet.frame, packet.sequence);
+        if (!output.empty()){
+            packet.processed = stream->pool.acquire(output.size(), output.type());
+            output.copyTo(packet.processed);
+        }else
+            packet.processed.release();
+        packet.processEnd = cv::getTickCount();
+        stream->frameAllocations.fetchAndStoreRelaxed(pipeline.getFrameAllocations());
+        stream->processMonitor.add(ticksToMs(packet.processStart, packet.processEnd),
+                                   ticksToMs(packet.captureEnd, packet.processStart));
+        if (!stream->presentQueue->push(packet))
+            break;
+    }
+    stream->activeWorkers.deref();
+}
+
+/** StreamPipeline **/
+StreamPipeline::StreamPipeline(PipelineSettings *settings) : pool(32){
+    this->settings=settings;
+    this->source=NULL;
+    this->profiler=NULL;
+    this->policy=QUEUE_DROP_OLDEST;
+    this->workers=QThread::idealThreadCount()-2;
+    if (this->workers<1)
+        this->workers=1;
+    this->captureQueue = new BoundedQueue<FramePacket>(4, this->policy);
+    this->presentQueue = new BoundedQueue<FramePacket>(4, this->policy);
+    this->lastPresented=0;
+}
+
+StreamPipeline::~StreamPipeline(){
+    stop();
+    delete this->captureQueue;
+    delete this->presentQueue;
+}
+
+// Number of processing threads, taken into account on the next start()
+void StreamPipeline::setWorkers(int n){
+    this->workers = n<1 ? 1 : n;
+}
+
+// Capacity of both queues, only applied while stopped
+void StreamPipeline::setQueueCapacity(int n){
+    if (isRunning())
+        return;
+    delete this->captureQueue;
+    delete this->presentQueue;
+    this->captureQueue = new BoundedQueue<FramePacket>(n, this->policy);
+    this->presentQueue = new BoundedQueue<FramePacket>(n, this->policy);
+}
+
+void StreamPipeline::setQueuePolicy(QueuePolicy policy){
+    this->policy=policy;
+    this->captureQueue->setPolicy(policy);
+    this->presentQueue->setPolicy(policy);
+}
+
+// Profiler the workers time their stages into, taken into account on the next start()
+void StreamPipeline::setProfiler(StageProfiler *profiler){
+    this->profiler=profiler;
+}
+
+void StreamPipeline::start(FrameSource *source){
+    stop();
+    this->source=source;
+    this->stopping.fetchAndStoreOrdered(0);
+    this->sourceEnded.fetchAndStoreOrdered(0);
+    this->staleDropped.fetchAndStoreOrdered(0);
+    this->activeWorkers.fetchAndStoreOrdered(this->workers);
+    this->lastPresented=0;
+    this->reorder.clear();
+    this->captureQueue->reopen();
+    this->presentQueue->reopen();
+    this->captureMonitor.reset();
+    this->processMonitor.reset();
+    this->presentMonitor.reset();
+
+    this->threads.push_back(new CaptureThread(this));
+    for (int i=0; i<this->workers; i++)
+        this->threads.push_back(new ProcessingWorker(this, i));
+    for (unsigned int i=0; i<this->threads.size(); i++)
+        this->threads[i]->start();
+}
+
+void StreamPipeline::stop(){
+    if (this->threads.empty())
+        return;
+    this->stopping.fetchAndStoreOrdered(1);
+    this->captureQueue->close();
+    this->presentQueue->close();
+    for (unsigned int i=0; i<this->threads.size(); i++){
+        this->threads[i]->wait();
+        delete this->threads[i];
+    }
+    this->threads.clear();
+}
+
+bool StreamPipeline::isRunning(){
+    return !this->threads.empty() && !this->stopping;
+}
+
+// The source is exhausted and every processed frame has been handed out
+bool StreamPipeline::isFinished(){
+    return this->sourceEnded && this->activeWorkers==0 && this->presentQueue->size()==0
+            && this->reorder.empty();
+}
+
+// Presentation stage: wait for the next processed frame. Workers finish out
+// of order; with QUEUE_DROP_OLDEST frames older than the last one handed out
+// are dropped and anything queued behind a newer frame is skipped too, with
+// QUEUE_BLOCK frames are held back until they can be handed out in sequence.
+bool StreamPipeline::next(FramePacket &packet, int timeoutMs){
+    FramePacket candidate, newer;
+    if (this->policy==QUEUE_BLOCK){
+        QTime timer;
+        timer.start();
+        std::map<quint64, FramePacket>::iterator it;
+        while ((it=this->reorder.find(this->lastPresented+1))==this->reorder.end()){
+            int left = timeoutMs-timer.elapsed();
+            if (!this->presentQueue->pop(candidate, left>0 ? left : 0)){
+                // Nothing else will arrive: hand out what is held back
+                if (this->activeWorkers==0 && !this->reorder.empty())
+                    this->lastPresented = this->reorder.begin()->first-1;
+                else
+                    return false;
+                continue;
+            }
+            this->reorder[candidate.sequence] = candidate;
+            // More frames held back than can be in flight: the one we wait
+            // for was dropped before the policy was switched, skip the gap
+            int inFlight = this->workers + this->captureQueue->capacity() + this->presentQueue->capacity();
+            if ((int)this->reorder.size()>inFlight)
+                this->lastPresented = this->reorder.begin()->first-1;
+        }
+        candidate = it->second;
+        this->reorder.erase(it);
+    }else{
+        this->reorder.clear();
+        if (!this->presentQueue->pop(candidate, timeoutMs))
+            return false;
+        for (;;){
+            while (this->presentQueue->tryPop(newer)){
+                this->staleDropped.ref();
+                if (newer.sequence>candidate.sequence)
+                    candidate=newer;
+            }
+            if (candidate.sequence>this->lastPresented)
+                break;
+            this->staleDropped.ref();
+            if (!this->presentQueue->tryPop(candidate))
+                return false;
+        }
+    }
+    this->lastPresented = candidate.sequence;
+    candidate.presentStart = cv::getTickCount();
+    packet = candidate;
+    return true;
+}
+
+// Called by the presentation stage once it is done with a packet from next()
+void StreamPipeline::presented(const FramePacket &packet){
+    this->presentMonitor.add(ticksToMs(packet.presentStart, cv::getTickCount()),
+                             ticksToMs(packet.processEnd, packet.presentStart));
+}
+
+StreamStats StreamPipeline::getStats(){
+    StreamStats stats;
+    PipelineConfig config;
+    this->settings->snapshot(config);
+    stats.workers = config.houghTracking ? 1 : this->workers;
+    stats.frameAllocations = this->frameAllocations;
+    stats.streamAllocations = this->pool.getAllocations();
+    this->captureMonitor.fill(stats.capture);
+    this->processMonitor.fill(stats.process);
+    this->presentMonitor.fill(stats.present);
+    stats.process.queueDepth = this->captureQueue->size();
+    stats.process.queueCapacity = this->captureQueue->capacity();
+    stats.process.dropped = this->captureQueue->getDropped();
+    stats.present.queueDepth = this->presentQueue->size();
+    stats.present.queueCapacity = this->presentQueue->capacity();
+    stats.present.dropped = this->presentQueue->getDropped() + this->staleDropped;
+    return stats;
+}
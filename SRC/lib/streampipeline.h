@@ -0,0 +1,124 @@
+/*
+    @file: streampipeline.h
+    @license: GNU General Public License
+    @author: Juan Manuel Perez Rua
+    @note: Code written for th practical module of
+    Visual Perception at the Université de Bourgogne
+*/
+
+#ifndef STREAMPIPELINE_H
+#define STREAMPIPELINE_H
+
+#include <vector>
+#include <map>
+#include <QThread>
+#include <QMutex>
+#include <QAtomicInt>
+#include <QTime>
+#include "opencv2/opencv.hpp"
+#include "boundedqueue.h"
+#include "framesource.h"
+#include "pipelineconfig.h"
+#include "stageprofiler.h"
+#include "framebufferpool.h"
+
+// A frame travelling through the stream, with the tick counts needed to
+// tell where it spent its time.
+struct FramePacket{
+    FramePacket();
+    quint64 sequence;
+    cv::Mat frame;      // as captured
+    cv::Mat processed;  // output of the processing stages
+    int64 captureStart;
+    int64 captureEnd;
+    int64 processStart;
+    int64 processEnd;
+    int64 presentStart;
+};
+
+struct StageStats{
+    StageStats();
+    int queueDepth;     // frames waiting in the queue feeding this stage
+    int queueCapacity;
+    int dropped;        // frames discarded before reaching this stage
+    quint64 frames;     // frames handled by this stage
+    double latencyMs;   // average time spent doing the stage work
+    double waitMs;      // average time spent queued in front of the stage
+};
+
+struct StreamStats{
+    StreamStats();
+    StageStats capture;
+    StageStats process;
+    StageStats present;
+    int workers;
+    int frameAllocations;   // buffers the last processed frame had to allocate
+    int streamAllocations;  // frame/output buffers allocated so far
+};
+
+// Running averages for one stage, updated from its own thread(s)
+class StageMonitor{
+public:
+    StageMonitor();
+    void add(double latencyMs, double waitMs);
+    void reset();
+    void fill(StageStats &stats);
+private:
+    QMutex mutex;
+    quint64 frames;
+    double latencyMs;
+    double waitMs;
+};
+
+// Capture -> processing -> presentation pipeline. One thread grabs frames
+// from a FrameSource, N workers each run their own ProcessingPipeline and
+// the presentation stage (the caller of next()) gets the processed frames,
+// newest first. Stages are decoupled by BoundedQueues so a slow detector
+// no longer stalls the camera; with QUEUE_DROP_OLDEST the stream stays live
+// by skipping frames, with QUEUE_BLOCK every frame is processed and handed
+// out in capture order. While hough tracking is on the other workers stay
+// idle and a single one processes every frame, in sequence, so the tracked
+// lines and circles always come from the previous frame.
+class StreamPipeline{
+public:
+    StreamPipeline(PipelineSettings *settings);
+    ~StreamPipeline();
+    void setWorkers(int n);
+    void setQueueCapacity(int n);
+    void setQueuePolicy(QueuePolicy policy);
+    void setProfiler(StageProfiler *profiler);
+    void start(FrameSource *source);
+    void stop();
+    bool isRunning();
+    bool isFinished();
+    bool next(FramePacket &packet, int timeoutMs);
+    void presented(const FramePacket &packet);
+    StreamStats getStats();
+
+private:
+    friend class CaptureThread;
+    friend class ProcessingWorker;
+    PipelineSettings *settings;
+    FrameSource *source;
+    StageProfiler *profiler;
+    BoundedQueue<FramePacket> *captureQueue;
+    BoundedQueue<FramePacket> *presentQueue;
+    std::vector<QThread*> threads;
+    QueuePolicy policy;
+    int workers;
+    QAtomicInt stopping;
+    QAtomicInt sourceEnded;
+    QAtomicInt activeWorkers;
+    QAtomicInt staleDropped;
+    QAtomicInt frameAllocations;
+    FrameBufferPool pool;   // captured frames and processed outputs
+    quint64 lastPresented;
+    std::map<quint64, FramePacket> reorder; // QUEUE_BLOCK frames waiting for their turn
+    StageMonitor captureMonitor;
+    StageMonitor processMonitor;
+    StageMonitor presentMonitor;
+    StreamPipeline(const StreamPipeline &);
+    StreamPipeline &operator=(const StreamPipeline &);
+};
+
+#endif // STREAMPIPELINE_H
@@ -17,7 +17,7 @@ MainWindow::MainWindow(QWidget *parent) :
     ui(new Ui::MainWindow){
     ui->setupUi(this);
 
-    this->timerImage = new QTimer();
+    this->frameChannel = new FrameChannel(this);
     this->timerVideo = new QTimer();
     this->currentView = 1;
     this->stereoView = 0;
@@ -29,6 +29,9 @@ MainWindow::MainWindow(QWidget *parent) :
     this->viewImage1Exist=false;
     this->viewImage2Exist=false;
 
+    connect(this->frameChannel, SIGNAL(frameReady()),
+            this, SLOT(update_image_label()));
+
     ui->actionsText->appendPlainText("Program started.");
 }
 
@@ -40,6 +43,7 @@ MainWindow::~MainWindow(){
 void MainWindow::start_computervision_thread(){
     this->visionThread = new QThread();
     this->computerVision = new ComputerVisionInterface();
+    this->computerVision->setFrameChannel(this->frameChannel);
     this->computerVision->moveToThread(this->visionThread);
     //this->computerVision->setLoopLock(true);
 
@@ -72,7 +76,6 @@ void MainWindow::on_buttonCam1_clicked(){
         ui->buttonCam1->setText("Stop CAM");
         ui->cameraLabel->setText("Camera Open");
         start_computervision_thread();
-        start_timer_image();
         computerVision->setWorkingOnCam(true);
         computerVision->setWorkingOnFrame(false);
         ui->tabWidget->setEnabled(true);
@@ -115,7 +118,6 @@ void MainWindow::on_openImageButton_clicked(){
             ui->openImageButton->setText("Stop File");
             ui->frameLabel->setText("Image Opened");
             start_computervision_thread();
-            start_timer_image();
             computerVision->setFrameFilename(fileName);
             computerVision->setWorkingOnFrame(true);
             computerVision->setWorkingOnCam(false);
@@ -131,9 +133,8 @@ void MainWindow::on_openImageButton_clicked(){
             ui->openImageButton->setText("Stop File");
             ui->frameLabel->setText("Video Opened");
             start_computervision_thread();
-            start_timer_image();
-            computerVision->setWorkingOnVideo(true);
             computerVision->setVideoFilename(fileName);
+            computerVision->setWorkingOnVideo(true);
             computerVision->setWorkingOnFrame(false);
             computerVision->setWorkingOnCam(false);
             start_timer_video();
@@ -179,9 +180,14 @@ void MainWindow::check_video_playing(){
 }
 
 void MainWindow::update_image_label(){
-    extern QImage qImage1;
-    extern QImage qProccessedImage;
-    extern QImage qImage1Histogram;
+    /* Repaint only when the vision thread has published a new frame */
+    VisionFramePtr frame = this->frameChannel->take();
+    if (frame.isNull())
+        return;
+    this->currentFrame = frame;
+    const QImage &qImage1 = frame->original;
+    const QImage &qProccessedImage = frame->processed;
+    const QImage &qImage1Histogram = frame->histogram;
 
     if (ui->tabWidget->currentIndex()==0){
         ui->Image1_2->setPixmap(QPixmap::fromImage(qImage1));
@@ -328,11 +334,6 @@ void MainWindow::update_image_label(){
     }
 }
 
-void MainWindow::start_timer_image(){
-    connect(timerImage, SIGNAL(timeout()), this, SLOT(update_image_label()));
-    timerImage->start(10);
-}
-
 void MainWindow::start_timer_video(){
     connect(timerVideo, SIGNAL(timeout()), this, SLOT(check_video_playing()));
     timerVideo->start(50);
@@ -817,9 +818,8 @@ void MainWindow::on_featureSlider2_valueChanged(int value){
 }
 
 void MainWindow::on_viewButton1_clicked(){
-    extern QImage qImage1;
     computerVision->selectView1();
-    this->viewImage1 = new QImage(qImage1);
+    this->viewImage1 = new QImage(this->currentFrame.isNull() ? QImage() : this->currentFrame->original);
     ui->Image4_2->setPixmap(QPixmap::fromImage(*viewImage1));
     ui->Image4_2->show();
     this->viewImage1Exist=true;
@@ -833,9 +833,8 @@ void MainWindow::on_viewButton1_clicked(){
 }
 
 void MainWindow::on_viewButton2_clicked(){
-    extern QImage qImage1;
     computerVision->selectView2();
-    this->viewImage2 = new QImage(qImage1);
+    this->viewImage2 = new QImage(this->currentFrame.isNull() ? QImage() : this->currentFrame->original);
     ui->Image4_3->setPixmap(QPixmap::fromImage(*viewImage2));
     ui->Image4_3->show();
     this->viewImage2Exist=true;
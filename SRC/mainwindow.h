@@ -25,7 +25,6 @@ public:
     explicit MainWindow(QWidget *parent = 0);
     ~MainWindow();
     void start_computervision_thread();
-    void start_timer_image(void);
     void start_timer_video(void);
     
 private slots:
@@ -95,7 +94,8 @@ private:
     Ui::MainWindow *ui;
     QThread* visionThread;
     ComputerVisionInterface *computerVision;
-    QTimer *timerImage; //show image yet?
+    FrameChannel *frameChannel; //frames published by the vision thread
+    VisionFramePtr currentFrame; //last frame painted
     QTimer *timerVideo; //are there still video frames?
     int currentView; /*0=original, 1=proccessed*/
     int stereoView;/*0: original, 1: view 1, 2: view 2*/
@@ -10,6 +10,7 @@
 #undef __SFM__DEBUG__
 
 #include "FeatureMatching.h"
+#include "robustestimator.h"
 #include <opencv2/features2d/features2d.hpp>
 #include <opencv2/highgui/highgui.hpp>
 #include <opencv2/video/tracking.hpp>
@@ -197,7 +198,12 @@ void MatchFeatures(const Mat& img_1, const Mat& img_1_orig,
 			cout << "pts1 " << pts1.size() << " (orig pts " << imgpts1_good.size() << ")" << endl;
 			cout << "pts2 " << pts2.size() << " (orig pts " << imgpts2_good.size() << ")" << endl;
 #endif
-			Mat F = findFundamentalMat(pts1, pts2, FM_RANSAC, 0.1, 0.99, status);
+			vector<float> quality;
+			for (unsigned int i=0; i<good_matches_.size(); i++) quality.push_back(good_matches_[i].distance);
+			RobustEstimator estimator;
+			estimator.setThreshold(0.1);
+			estimator.setConfidence(0.99);
+			Mat F = estimator.findFundamental(pts1, pts2, status, quality);
 		}
 		cout << "Fundamental mat is keeping " << countNonZero(status) << " / " << status.size() << endl;	
 		
@@ -9,6 +9,7 @@
 
 #include "FindCameraMatrices.h"
 #include "Triangulation.h"
+#include "robustestimator.h"
 
 #include <vector>
 #include <iostream>
@@ -165,7 +166,14 @@ Mat GetFundamentalMat(const vector<KeyPoint>& imgpts1,
 #endif
 		double minVal,maxVal;
 		cv::minMaxIdx(pts1,&minVal,&maxVal);
-		F = findFundamentalMat(pts1, pts2, FM_RANSAC, 0.006 * maxVal, 0.99, status); //threshold from [Snavely07 4.1]
+		//PROSAC ordered by match distance when the matches are given
+		vector<float> quality;
+		if (matches.size() == pts1.size())
+			for (unsigned int i=0; i<matches.size(); i++) quality.push_back(matches[i].distance);
+		RobustEstimator estimator;
+		estimator.setThreshold(0.006 * maxVal); //threshold from [Snavely07 4.1]
+		estimator.setConfidence(0.99);
+		F = estimator.findFundamental(pts1, pts2, status, quality);
 	}
 	
 	vector<DMatch> new_matches;